@@ -12,8 +12,10 @@ header('Content-Type: application/json; charset=utf-8');
  * Ermittelt den Ländercode (ISO-3166 Alpha-2) anhand eines Rufzeichen-Präfixes.
  * Hinweis:
  * - Mapping ist bewusst statisch und unvollständig/uneinheitlich (DX real life).
- * - Reihenfolge ist wichtig: längere Präfixe müssen davor stehen (z. B. "OH0" vor "OH").
- * - Keine Logikänderung: Mapping bleibt exakt wie vorgefunden, inkl. Duplikate.
+ * - Es gilt das längste passende Präfix (z. B. "OH0" vor "OH"), wie in FMparser.
+ * - Nur noch Fallback: FMparser löst den Code einmal je Callsign auf und speichert
+ *   ihn in callsigns.country_code. Die Liste dort (gui/parser/country_prefixes.txt)
+ *   ist aus diesem Mapping erzeugt, Änderungen in beiden nachziehen.
  *
  * @param mixed $call Rufzeichen (beliebiger Typ, wird intern zu String gecastet)
  * @return string|null ISO-3166-Code oder null, wenn kein Match
@@ -86,6 +88,9 @@ function prefix_to_country($call) {
       // --- Sonderrufe ---
       'AM' => 'ES', 'AN' => 'ES', 'AO' => 'ES', 'EG' => 'ES', 'EH' => 'ES', 'EM' => 'UA', 'EN' => 'UA', 'EO' => 'UA'
     ];
+
+    // längste Präfixe zuerst (stabil, gleich lange in der Reihenfolge oben)
+    uksort($map, static fn ($a, $b) => strlen((string)$b) <=> strlen((string)$a));
   }
 
   // Eingabe aufbereiten
@@ -94,7 +99,7 @@ function prefix_to_country($call) {
     return null;
   }
 
-  // Präfix-Match (greedy von links nach rechts)
+  // erstes Präfix in der sortierten Liste = längstes passendes
   foreach ($map as $pfx => $cc) {
     if (str_starts_with($call, $pfx)) {
       return $cc;
@@ -168,7 +173,145 @@ function bm_api_get(string $endpoint, string $token, bool $debug = false): array
   return ['ok' => true, 'code' => $code, 'data' => $json];
 }
 
+/**
+ * Zeitfenster der Top-Listen aus $_GET['window'] (Spalte fmstats.window).
+ * FMparser schreibt 24h, 7d, 30d und 365d; alles andere -> 30d (bisheriges Verhalten).
+ */
+function fm_stats_window(): string {
+  $w = $_GET['window'] ?? '30d';
+  return in_array($w, ['24h', '7d', '30d', '365d'], true) ? $w : '30d';
+}
+
+/**
+ * Filter der Top-Listen aus $_GET['mode'] -> [SQL-Bedingung, Parameter] auf fmstats.
+ * - local:     Liste der einen TG aus tg=... (scope 'tg')
+ * - monitored: Liste über die Monitor-TGs der config (scope 'monitored'); FMparser
+ *              rechnet sie aus monitor_tgs, tgs=... der GUI ist dieselbe Liste
+ * - sonst:     globale Liste (scope 'all')
+ * Listen pro TG schreibt FMparser für die 50 aktivsten und die konfigurierten TGs,
+ * für andere TGs bleibt das Ergebnis leer.
+ */
+function fm_stats_scope(): array {
+  $mode = $_GET['mode'] ?? 'all';
+
+  if ($mode === 'local') {
+    $tg = isset($_GET['tg']) ? (int)$_GET['tg'] : 0;
+    if ($tg > 0) {
+      return ["scope = 'tg' AND tg = :tg", [':tg' => $tg]];
+    }
+  } elseif ($mode === 'monitored') {
+    return ["scope = 'monitored'", []];
+  }
+
+  return ["scope = 'all'", []];
+}
+
+/**
+ * LiveApi von FMparser (http_bind/http_port in fmparser.conf): beantwortet die
+ * Live-Abfragen aus dem Speicher, gleiche Parameter und JSON-Form wie hier.
+ */
+const FM_PARSER_CONF  = '/etc/svxlink/fmparser.conf';
+const FM_LIVE_QUERIES = [
+  'fmstatus', 'fmlastheard', 'fmheatmap',
+  'fm_callsignTop10Count', 'fm_callsignTop10Duration',
+  'fm_hallOfFameWeek', 'fm_topTalkgroups', 'parser_status',
+];
+
+/**
+ * URL der LiveApi aus fmparser.conf, gleiche Regeln und Defaults wie
+ * ParserSettings in FMparser (key = value, Kommentare mit # oder ;).
+ * @return string|null URL, oder null bei http_port = 0 (LiveApi aus)
+ */
+function fm_live_api_url(): ?string {
+  $bind = '127.0.0.1';
+  $port = 8088;
+
+  $lines = @file(FM_PARSER_CONF, FILE_IGNORE_NEW_LINES);
+  foreach ($lines ?: [] as $line) {
+    $t = trim($line);
+    if ($t === '' || in_array($t[0], ['#', ';', '['], true) || !str_contains($t, '=')) {
+      continue;
+    }
+    [$key, $val] = array_map('trim', explode('=', $t, 2));
+    if ($key === 'http_bind' && $val !== '') {
+      $bind = $val;
+    } elseif ($key === 'http_port' && ctype_digit($val) && (int)$val <= 65535) {
+      $port = (int)$val;
+    }
+  }
+
+  if ($port === 0) {
+    return null;
+  }
+  // auf allen Adressen gebunden -> lokal erreichbar (http_bind ist nur IPv4)
+  if ($bind === '0.0.0.0') {
+    $bind = '127.0.0.1';
+  }
+  return "http://{$bind}:{$port}/api";
+}
+
+/**
+ * Fragt die LiveApi mit dem Query-String dieser Anfrage.
+ * @return array|null Zeilen, oder null (FMparser aus, nicht bereit, Fehler) -> MySQL
+ */
+function fm_live_api(): ?array {
+  $url = fm_live_api_url();
+  if ($url === null) {
+    return null;
+  }
+
+  $ctx = stream_context_create([
+    'http' => ['timeout' => 0.5, 'ignore_errors' => true],
+  ]);
+  $body = @file_get_contents($url . '?' . ($_SERVER['QUERY_STRING'] ?? ''), false, $ctx);
+  if ($body === false) {
+    return null;
+  }
+
+  // Statuszeile "HTTP/1.1 200 OK"; 503 = Statistik/Writer noch nicht bereit
+  $status = $http_response_header[0] ?? '';
+  if (!preg_match('#^HTTP/\S+\s+200\b#', $status)) {
+    return null;
+  }
+
+  $rows = json_decode($body, true);
+  return is_array($rows) ? $rows : null;
+}
+
 try {
+  // Abfrageparameter: q=...
+  $q = $_GET['q'] ?? 'status';
+
+  // Live-Abfragen zuerst aus FMparser, MySQL nur als Fallback
+  if (in_array($q, FM_LIVE_QUERIES, true)) {
+    $data = fm_live_api();
+    if ($data !== null) {
+      // fmlastheard&since=...: {seq, full, rows}, sonst direkt die Zeilen
+      if (isset($data['rows']) && is_array($data['rows'])) {
+        $rows = &$data['rows'];
+      } else {
+        $rows = &$data;
+      }
+      // country_code liefert FMparser mit; ältere Versionen ohne -> hier auflösen
+      foreach ($rows as &$r) {
+        if (is_array($r) && array_key_exists('callsign', $r) && !array_key_exists('country_code', $r)) {
+          $r['country_code'] = prefix_to_country($r['callsign']);
+        }
+      }
+      unset($r, $rows);
+
+      echo json_encode($data, JSON_UNESCAPED_UNICODE);
+      exit;
+    }
+  }
+
+  // parser_status gibt es nur aus FMparser, MySQL kennt keinen Stand
+  if ($q === 'parser_status') {
+    http_response_code(503);
+    echo json_encode(['error' => 'FMparser not available'], JSON_UNESCAPED_UNICODE);
+    exit;
+  }
+
   /**
    * DB-Verbindung (Unix-Socket, kein TCP).
    * - ERRMODE_EXCEPTION: Fehler werden als Exceptions geworfen.
@@ -186,9 +329,6 @@ try {
     ]
   );
 
-  // Abfrageparameter: q=...
-  $q = $_GET['q'] ?? 'status';
-
   /* =========================
      OpenFM: Config für setup.html
      q=config_inbox
@@ -298,11 +438,13 @@ try {
     }
 
   /* =========================
-     FM: Last Heard (nur talk = 'stop', inkl. Dauer + location)
+     FM: Last Heard (abgeschlossene QSOs aus fmqso, inkl. Dauer + location)
      mit Server-Side-Filterung:
        mode=all
        mode=local&tg=123
        mode=monitored&tgs=1,2,3
+     since=<seq> beantwortet nur FMparser (nur neue Zeilen als {seq, full, rows});
+     hier ohne FMparser immer die komplette Liste
      ========================= */
   if ($q === 'fmlastheard') {
     $mode = $_GET['mode'] ?? 'all';
@@ -338,33 +480,26 @@ try {
       }
     }
 
+    // fmqso: start/stop schon beim Schreiben gepaart (FMparser), eine Zeile
+    // je stop -> Range über idx_end_time bzw. idx_tg_end statt Unterabfrage je Zeile
     $sql = "
       SELECT
         s.callsign,
         s.tg,
         s.server,
-        s.talk,
-        DATE_FORMAT(s.event_time, '%Y-%m-%d %H:%i:%s') AS event_time,
-        TIMESTAMPDIFF(
-          SECOND,
-          (
-            SELECT MAX(start.event_time)
-            FROM fmlastheard start
-            WHERE start.callsign   = s.callsign
-              AND start.tg         = s.tg
-              AND start.server     = s.server
-              AND start.talk       = 'start'
-              AND start.event_time <= s.event_time
-          ),
-          s.event_time
-        ) AS duration_s,
-        n.location
-      FROM fmlastheard s
+        'stop' AS talk,
+        DATE_FORMAT(s.end_time, '%Y-%m-%d %H:%i:%s') AS event_time,
+        s.duration_s,
+        n.location,
+        c.country_code
+      FROM fmqso s
       LEFT JOIN nodes n
         ON n.callsign = s.callsign
-      WHERE s.talk = 'stop'
+      LEFT JOIN callsigns c
+        ON c.id = s.callsign_id
+      WHERE 1 = 1
       {$sqlFilter}
-      ORDER BY s.event_time DESC
+      ORDER BY s.end_time DESC
       LIMIT 50
     ";
 
@@ -372,8 +507,9 @@ try {
     $stmt->execute($params);
     $rows = $stmt->fetchAll(PDO::FETCH_ASSOC);
 
+    // gespeichert von FMparser; fehlt er (alte Zeilen), hier auflösen
     foreach ($rows as &$r) {
-      $r['country_code'] = prefix_to_country($r['callsign'] ?? null);
+      $r['country_code'] = $r['country_code'] ?? prefix_to_country($r['callsign'] ?? null);
     }
 
     echo json_encode($rows, JSON_UNESCAPED_UNICODE);
@@ -390,15 +526,19 @@ try {
         s.tg,
         s.server,
         DATE_FORMAT(s.event_time, '%Y-%m-%d %H:%i:%s') AS event_time,
-        n.location
+        n.location,
+        c.country_code
       FROM fmstatus s
       LEFT JOIN nodes n
         ON n.callsign = s.callsign
+      LEFT JOIN callsigns c
+        ON c.callsign = s.callsign
       ORDER BY s.event_time DESC
     ")->fetchAll(PDO::FETCH_ASSOC);
 
+    // gespeichert von FMparser; fehlt er (alte Zeilen), hier auflösen
     foreach ($rows as &$r) {
-      $r['country_code'] = prefix_to_country($r['callsign'] ?? null);
+      $r['country_code'] = $r['country_code'] ?? prefix_to_country($r['callsign'] ?? null);
     }
 
     echo json_encode($rows, JSON_UNESCAPED_UNICODE);
@@ -409,22 +549,31 @@ try {
      FM: Top 10 Callsigns nach Anzahl TX
      q=fm_callsignTop10Count
      Optional: mode=all|local|monitored, tg=NUM, tgs=1,2,3
+     Optional: window=24h|7d|30d|365d (Default 30d)
      ========================= */
   if ($q === 'fm_callsignTop10Count') {
       // Top 10 Callsigns nach QSO-Anzahl aus fmstats
-      $rows = $pdo->query("
+      [$scopeSql, $scopeParams] = fm_stats_scope();
+      $stmt = $pdo->prepare("
           SELECT
-            callsign,
-            COALESCE(qso_count, 0) AS cnt
-          FROM fmstats
+            st.callsign,
+            COALESCE(st.qso_count, 0) AS cnt,
+            c.country_code
+          FROM fmstats st
+          LEFT JOIN callsigns c
+            ON c.callsign = st.callsign
           WHERE metric = 'top_calls_qso'
+            AND `window` = :w
+            AND {$scopeSql}
           ORDER BY rank ASC
           LIMIT 10
-      ")->fetchAll(PDO::FETCH_ASSOC);
+      ");
+      $stmt->execute([':w' => fm_stats_window()] + $scopeParams);
+      $rows = $stmt->fetchAll(PDO::FETCH_ASSOC);
 
       foreach ($rows as &$r) {
           $r['cnt'] = (int)($r['cnt'] ?? 0);
-          $r['country_code'] = prefix_to_country($r['callsign'] ?? null);
+          $r['country_code'] = $r['country_code'] ?? prefix_to_country($r['callsign'] ?? null);
       }
       unset($r);
 
@@ -436,22 +585,31 @@ try {
      FM: Top 10 Callsigns nach Gesamtsendezeit
      q=fm_callsignTop10Duration
      Optional: mode=all|local|monitored, tg=NUM, tgs=1,2,3
+     Optional: window=24h|7d|30d|365d (Default 30d)
      ========================= */
   if ($q === 'fm_callsignTop10Duration') {
       // Top 10 Callsigns nach Gesamtdauer (Sekunden) aus fmstats
-      $rows = $pdo->query("
+      [$scopeSql, $scopeParams] = fm_stats_scope();
+      $stmt = $pdo->prepare("
           SELECT
-            callsign,
-            COALESCE(total_seconds, 0) AS sec
-          FROM fmstats
+            st.callsign,
+            COALESCE(st.total_seconds, 0) AS sec,
+            c.country_code
+          FROM fmstats st
+          LEFT JOIN callsigns c
+            ON c.callsign = st.callsign
           WHERE metric = 'top_calls_duration'
+            AND `window` = :w
+            AND {$scopeSql}
           ORDER BY rank ASC
           LIMIT 10
-      ")->fetchAll(PDO::FETCH_ASSOC);
+      ");
+      $stmt->execute([':w' => fm_stats_window()] + $scopeParams);
+      $rows = $stmt->fetchAll(PDO::FETCH_ASSOC);
 
       foreach ($rows as &$r) {
           $r['sec'] = (float)($r['sec'] ?? 0.0);
-          $r['country_code'] = prefix_to_country($r['callsign'] ?? null);
+          $r['country_code'] = $r['country_code'] ?? prefix_to_country($r['callsign'] ?? null);
       }
       unset($r);
 
@@ -463,20 +621,28 @@ try {
     /* =========================
      FM: Hall of Fame – Top Callsigns der Monat (30 Tage)
      q=fm_hallOfFameWeek
+     Optional: window=24h|7d|30d|365d (Default 30d)
      ========================= */
   if ($q === 'fm_hallOfFameWeek') {
     // Hall of Fame: Top-Calls nach Score aus fmstats
-    $rows = $pdo->query("
+    $stmt = $pdo->prepare("
         SELECT
-          callsign,
-          COALESCE(qso_count,     0) AS qso_count,
-          COALESCE(total_seconds, 0) AS total_sec,
-          COALESCE(score,         0) AS score
-        FROM fmstats
+          st.callsign,
+          COALESCE(st.qso_count,     0) AS qso_count,
+          COALESCE(st.total_seconds, 0) AS total_sec,
+          COALESCE(st.score,         0) AS score,
+          c.country_code
+        FROM fmstats st
+        LEFT JOIN callsigns c
+          ON c.callsign = st.callsign
         WHERE metric = 'top_calls_score'
+          AND `window` = :w
+          AND scope = 'all'
         ORDER BY rank ASC
         LIMIT 10
-    ")->fetchAll(PDO::FETCH_ASSOC);
+    ");
+    $stmt->execute([':w' => fm_stats_window()]);
+    $rows = $stmt->fetchAll(PDO::FETCH_ASSOC);
 
     foreach ($rows as &$r) {
         $qso = (int)($r['qso_count'] ?? 0);
@@ -485,7 +651,7 @@ try {
         $r['total_sec']   = $tot;
         $r['score']       = (float)($r['score'] ?? 0.0);
         $r['avg_sec']     = $qso > 0 ? $tot / $qso : 0.0;
-        $r['country_code'] = prefix_to_country($r['callsign'] ?? null);
+        $r['country_code'] = $r['country_code'] ?? prefix_to_country($r['callsign'] ?? null);
     }
     unset($r);
 
@@ -497,19 +663,24 @@ try {
      FM: Top Talkgroups (global)
      q=fm_topTalkgroups
      Immer global (kein Filter nach Default/Monitor)
+     Optional: window=24h|7d|30d|365d (Default 30d)
      ========================= */
 if ($q === 'fm_topTalkgroups') {
     // Top Talkgroups nach Gesamtdauer aus fmstats
-    $rows = $pdo->query("
+    $stmt = $pdo->prepare("
         SELECT
           tg,
           COALESCE(qso_count,     0) AS cnt,
           COALESCE(total_seconds, 0) AS total_sec
         FROM fmstats
         WHERE metric = 'top_tg_duration'
+          AND `window` = :w
+          AND scope = 'all'
         ORDER BY rank ASC
         LIMIT 10
-    ")->fetchAll(PDO::FETCH_ASSOC);
+    ");
+    $stmt->execute([':w' => fm_stats_window()]);
+    $rows = $stmt->fetchAll(PDO::FETCH_ASSOC);
 
     foreach ($rows as &$r) {
         $cnt = (int)($r['cnt'] ?? 0);
@@ -1,7 +1,11 @@
 // MqttListener.cpp
 #include "MqttListener.h"
-#include "fmdatabase.h"
+#include "db_writer.h"
+#include "parser_settings.h"
+#include "payload_parser.h"
+#include "mqtt_capture.h"
 
+#include <chrono>
 #include <iostream>
 #include <cstring>
 #include <nlohmann/json.hpp>
@@ -16,6 +20,9 @@ bool MqttListener::init()
 
     mosquitto_lib_init();
 
+    s_host = ParserSettings::mqttHost;
+    s_port = ParserSettings::mqttPort;
+
     s_mosq = mosquitto_new(s_clientId.c_str(), true, nullptr);
     if (!s_mosq) {
         std::cerr << "[MqttListener] mosquitto_new() failed\n";
@@ -35,8 +42,17 @@ bool MqttListener::init()
     mosquitto_disconnect_callback_set(s_mosq, &MqttListener::onDisconnect);
     mosquitto_log_callback_set(s_mosq, &MqttListener::onLog);
 
-    // eigene DB
-    s_db = new FMDatabase();
+    // DB-Writer mit eigener DB
+    s_writer = new DbWriter(ParserSettings::queueCapacity,
+                            ParserSettings::batchSize,
+                            ParserSettings::batchFlushMs,
+                            ParserSettings::spoolFile,
+                            ParserSettings::spoolMaxMb * 1024 * 1024);
+
+    // optionaler Mitschnitt für FMreplay
+    if (!ParserSettings::captureFile.empty()) {
+        MqttCapture::open(ParserSettings::captureFile);
+    }
 
     s_initialized = true;
     return true;
@@ -53,6 +69,9 @@ void MqttListener::start()
         return;
     }
 
+    // Writer zuerst, damit kein Event verloren geht
+    s_writer->start();
+
     // asynchron verbinden
     int rc = mosquitto_connect_async(s_mosq, s_host.c_str(), s_port, 60);
     if (rc != MOSQ_ERR_SUCCESS) {
@@ -73,6 +92,24 @@ void MqttListener::start()
     std::cout << "[MqttListener] loop started, waiting for messages...\n";
 }
 
+void MqttListener::startOffline()
+{
+    if (!s_initialized.load()) {
+        std::cerr << "[MqttListener] Not initialized\n";
+        std::exit(EXIT_FAILURE);
+    }
+    if (s_running.load()) {
+        std::cerr << "[MqttListener] Already running\n";
+        return;
+    }
+
+    s_writer->start();
+
+    s_offline = true;
+    s_running = true;
+    std::cout << "[MqttListener] offline, messages via handleMessage()\n";
+}
+
 void MqttListener::stop()
 {
     if (!s_running.load())
@@ -81,25 +118,74 @@ void MqttListener::stop()
     s_running = false;
 
     if (s_mosq) {
-        mosquitto_disconnect(s_mosq);
-        mosquitto_loop_stop(s_mosq, true); // true = Thread blockierend beenden
+        if (!s_offline.load()) {
+            mosquitto_disconnect(s_mosq);
+            mosquitto_loop_stop(s_mosq, true); // true = Thread blockierend beenden
+        }
         mosquitto_destroy(s_mosq);
         s_mosq = nullptr;
     }
 
     mosquitto_lib_cleanup();
 
-    delete s_db;
-    s_db = nullptr;
+    MqttCapture::close();
+
+    // es kommen keine Events mehr -> Queue abarbeiten, dann beenden
+    s_writer->stop();
+    delete s_writer;
+    s_writer = nullptr;
 
     s_initialized = false;
+    s_offline = false;
+    s_connected = false;
 
     std::cout << "[MqttListener] stopped\n";
 }
 
+std::size_t MqttListener::queueDepth()
+{
+    return s_writer ? s_writer->queueDepth() : 0;
+}
+
+std::size_t MqttListener::queueCapacity()
+{
+    return s_writer ? s_writer->queueCapacity() : 0;
+}
+
+std::uint64_t MqttListener::queueDrops()
+{
+    return s_writer ? s_writer->drops() : 0;
+}
+
+QsoAggregator* MqttListener::qsoAggregator()
+{
+    return s_writer ? &s_writer->qsoAggregator() : nullptr;
+}
+
+const ActiveTalkers* MqttListener::activeTalkers()
+{
+    return s_writer ? &s_writer->activeTalkers() : nullptr;
+}
+
+const LastHeard* MqttListener::lastHeard()
+{
+    return s_writer ? &s_writer->lastHeard() : nullptr;
+}
+
+void MqttListener::setChangeSink(std::function<void(const LiveChange&)> sink)
+{
+    if (s_writer) s_writer->setChangeSink(std::move(sink));
+}
+
+void MqttListener::setLatencySink(std::vector<std::uint64_t>* sink)
+{
+    if (s_writer) s_writer->setLatencySink(sink);
+}
+
 void MqttListener::onConnect(struct mosquitto* /*mosq*/, void* /*userdata*/, int rc)
 {
     std::cout << "[MqttListener] onConnect rc=" << rc << "\n";
+    s_connected = (rc == 0);
     if (rc == 0) {
         // Talker-Events
         std::cout << "[MqttListener] Subscribing to topic: /server/statethr/1\n";
@@ -125,6 +211,7 @@ void MqttListener::onDisconnect(struct mosquitto* /*mosq*/,
                                 void* /*userdata*/,
                                 int rc)
 {
+    s_connected = false;
     std::cerr << "[MqttListener] onDisconnect rc=" << rc << "\n";
     // rc == 0 -> sauber getrennt
     // rc > 0  -> unerwartet (vom Broker oder Fehler)
@@ -143,12 +230,14 @@ void MqttListener::onMessage(struct mosquitto* /*mosq*/,
                              void* /*userdata*/,
                              const struct mosquitto_message* msg)
 {
-    std::string topic = msg->topic ? msg->topic : "";
+    if (!s_writer || !msg->topic) return;
 
-    std::string payload;
+    // direkt auf dem mosquitto-Puffer arbeiten, keine Kopie
+    std::string_view topic(msg->topic);
+    std::string_view payload;
     if (msg->payload && msg->payloadlen > 0) {
-        payload.assign(static_cast<char*>(msg->payload),
-                       static_cast<size_t>(msg->payloadlen));
+        payload = std::string_view(static_cast<const char*>(msg->payload),
+                                   static_cast<size_t>(msg->payloadlen));
     }
 
     /*
@@ -157,87 +246,129 @@ void MqttListener::onMessage(struct mosquitto* /*mosq*/,
               << " | Retain: " << msg->retain
               << " | Payload: " << payload << "\n";
     */
-    if (!s_db) return;
+
+    if (!ParserSettings::captureFile.empty()) {
+        MqttCapture::record(topic, payload, MqttCapture::wallNs());
+    }
+
+    handleMessage(topic, payload);
+}
+
+void MqttListener::handleMessage(std::string_view topic, std::string_view payload)
+{
+    if (!s_writer) return;
+
+    using namespace std::chrono;
+    std::uint64_t recvNs = static_cast<std::uint64_t>(
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+
+    ++s_messages;
 
     // Whitespace vorne weg
-    std::string trimmed = payload;
-    while (!trimmed.empty() && (trimmed[0] == ' ' || trimmed[0] == '\t' ||
-                                trimmed[0] == '\r' || trimmed[0] == '\n')) {
-        trimmed.erase(trimmed.begin());
+    std::size_t first = payload.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos || payload[first] != '{') {
+        return;
     }
+    payload.remove_prefix(first);
 
     // 1) Talker-Events (/server/statethr...)
     if (topic.rfind("/server/statethr", 0) == 0) {
-        if (!trimmed.empty() && trimmed[0] == '{') {
-            try {
-                json j = json::parse(trimmed);
-
-                std::string timeStr  = j.value("time",   "");
-                std::string talkStr  = j.value("talk",   "");
-                std::string callStr  = j.value("call",   "");
-                std::string tgStr    = j.value("tg",     "");
-                std::string srvStr   = j.value("server", "");
-
-                if (!timeStr.empty() && !talkStr.empty() &&
-                    !callStr.empty() && !tgStr.empty()) {
-                    if (!s_db->insertEvent(timeStr, talkStr, callStr, tgStr, srvStr)) {
-                        std::cerr << "[MqttListener] insertEvent failed\n";
-                    }
-                } else {
-                    std::cerr << "[MqttListener] JSON (statethr) missing required fields\n";
-                }
-
-            } catch (const std::exception& e) {
-                std::cerr << "[MqttListener] JSON parse error (statethr): " << e.what() << "\n";
-            }
-        }
+        handleTalk(payload, recvNs);
     }
     // 2) Node-Infos (/server/state/nodes/...)
     else if (topic.rfind("/server/state/nodes/", 0) == 0) {
-        if (!trimmed.empty() && trimmed[0] == '{') {
-            try {
-                json j = json::parse(trimmed);
-
-                std::string call     = j.value("call",     "");
-                std::string location = j.value("location", "");
-                std::string locator  = j.value("locator",  "");
-                std::string rx_freq  = j.value("rx_freq",  "");
-                std::string tx_freq  = j.value("tx_freq",  "");
-
-                double lat = std::numeric_limits<double>::quiet_NaN();
-                double lon = std::numeric_limits<double>::quiet_NaN();
-
-                // lat/lon können null sein
-                if (j.contains("lat") && !j["lat"].is_null()) {
-                    if (j["lat"].is_number_float() || j["lat"].is_number_integer()) {
-                        lat = j["lat"].get<double>();
-                    } else if (j["lat"].is_string()) {
-                        try {
-                            lat = std::stod(j["lat"].get<std::string>());
-                        } catch (...) {}
-                    }
-                }
-                if (j.contains("lon") && !j["lon"].is_null()) {
-                    if (j["lon"].is_number_float() || j["lon"].is_number_integer()) {
-                        lon = j["lon"].get<double>();
-                    } else if (j["lon"].is_string()) {
-                        try {
-                            lon = std::stod(j["lon"].get<std::string>());
-                        } catch (...) {}
-                    }
-                }
+        handleNode(payload, recvNs);
+    }
+}
+
+void MqttListener::handleTalk(std::string_view payload, std::uint64_t recvNs)
+{
+    FMEvent ev;
+    ev.kind = FMEvent::Kind::Talk;
+    ev.recvNs = recvNs;
+
+    PayloadParser::TalkFields f;
+    if (PayloadParser::parseTalk(payload, f)) {
+        ev.time.assign(f.time);
+        ev.talk.assign(f.talk);
+        ev.call.assign(f.call);
+        ev.tg.assign(f.tg);
+        ev.server.assign(f.server);
+    } else {
+        // Fallback für alles, was nicht ins einfache Schema passt
+        try {
+            json j = json::parse(payload.begin(), payload.end());
+
+            ev.time   = j.value("time",   "");
+            ev.talk   = j.value("talk",   "");
+            ev.call   = j.value("call",   "");
+            ev.tg     = j.value("tg",     "");
+            ev.server = j.value("server", "");
+
+        } catch (const std::exception& e) {
+            std::cerr << "[MqttListener] JSON parse error (statethr): " << e.what() << "\n";
+            return;
+        }
+    }
 
-                if (!call.empty()) {
-                    if (!s_db->upsertNode(call, location, locator, lat, lon, rx_freq, tx_freq)) {
-                        std::cerr << "[MqttListener] upsertNode failed\n";
-                    }
-                } else {
-                    std::cerr << "[MqttListener] nodes JSON without call - ignored\n";
+    if (ev.time.empty() || ev.talk.empty() || ev.call.empty() || ev.tg.empty()) {
+        std::cerr << "[MqttListener] JSON (statethr) missing required fields\n";
+        return;
+    }
+
+    s_writer->push(std::move(ev));
+}
+
+void MqttListener::handleNode(std::string_view payload, std::uint64_t recvNs)
+{
+    FMEvent ev;
+    ev.kind = FMEvent::Kind::Node;
+    ev.recvNs = recvNs;
+
+    PayloadParser::NodeFields f;
+    if (PayloadParser::parseNode(payload, f)) {
+        ev.call.assign(f.call);
+        ev.location.assign(f.location);
+        ev.locator.assign(f.locator);
+        ev.rxFreq.assign(f.rxFreq);
+        ev.txFreq.assign(f.txFreq);
+        ev.lat = f.lat;
+        ev.lon = f.lon;
+    } else {
+        // Fallback für alles, was nicht ins einfache Schema passt
+        try {
+            json j = json::parse(payload.begin(), payload.end());
+
+            ev.call     = j.value("call",     "");
+            ev.location = j.value("location", "");
+            ev.locator  = j.value("locator",  "");
+            ev.rxFreq   = j.value("rx_freq",  "");
+            ev.txFreq   = j.value("tx_freq",  "");
+
+            // lat/lon können null sein
+            auto readCoord = [&j](const char* key, double& out) {
+                if (!j.contains(key) || j[key].is_null()) return;
+                if (j[key].is_number_float() || j[key].is_number_integer()) {
+                    out = j[key].get<double>();
+                } else if (j[key].is_string()) {
+                    try {
+                        out = std::stod(j[key].get<std::string>());
+                    } catch (...) {}
                 }
+            };
+            readCoord("lat", ev.lat);
+            readCoord("lon", ev.lon);
 
-            } catch (const std::exception& e) {
-                std::cerr << "[MqttListener] JSON parse error (nodes): " << e.what() << "\n";
-            }
+        } catch (const std::exception& e) {
+            std::cerr << "[MqttListener] JSON parse error (nodes): " << e.what() << "\n";
+            return;
         }
     }
+
+    if (ev.call.empty()) {
+        std::cerr << "[MqttListener] nodes JSON without call - ignored\n";
+        return;
+    }
+
+    s_writer->push(std::move(ev));
 }
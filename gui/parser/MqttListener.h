@@ -2,12 +2,20 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <thread>
 #include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
 #include <mosquitto.h>
 #include <unistd.h>
 
-class FMDatabase; // forward
+class DbWriter; // forward
+class QsoAggregator;
+class ActiveTalkers;
+class LastHeard;
+struct LiveChange;
 
 class MqttListener {
 public:
@@ -16,6 +24,32 @@ public:
     static void start();
     static void stop();
 
+    // nur den DB-Writer starten, ohne Broker (FMreplay füttert handleMessage direkt)
+    static void startOffline();
+
+    // eine rohe MQTT-Nachricht verarbeiten (aus onMessage oder FMreplay)
+    static void handleMessage(std::string_view topic, std::string_view payload);
+
+    // Zähler der Event-Queue (MQTT-Thread -> DB-Writer)
+    static std::size_t   queueDepth();
+    static std::size_t   queueCapacity();
+    static std::uint64_t queueDrops();
+
+    // laufende QSO-Statistik des Writers (nullptr, solange nicht initialisiert)
+    static QsoAggregator* qsoAggregator();
+
+    // Live-Zustand des Writers für die LiveApi (nullptr, solange nicht initialisiert)
+    static const ActiveTalkers* activeTalkers();
+    static const LastHeard*     lastHeard();
+
+    // Live-Änderungen an die LiveApi (SSE); nach init(), vor start() setzen
+    static void setChangeSink(std::function<void(const LiveChange&)> sink);
+
+    // für FMreplay
+    static std::uint64_t messagesHandled() { return s_messages.load(); }
+    static bool          isConnected()     { return s_connected.load(); }
+    static void          setLatencySink(std::vector<std::uint64_t>* sink);
+
 private:
     MqttListener() = delete;
 
@@ -24,6 +58,9 @@ private:
     static void onDisconnect(struct mosquitto* mosq, void* userdata, int rc);
     static void onLog(struct mosquitto* mosq, void* userdata, int level, const char* str);
 
+    static void handleTalk(std::string_view payload, std::uint64_t recvNs);
+    static void handleNode(std::string_view payload, std::uint64_t recvNs);
+
     static inline std::string s_host = "mqtt.fm-funknetz.de";
     static inline int         s_port = 1883;
     static inline std::string s_clientId = "openFM-" + std::to_string(getpid());
@@ -32,7 +69,10 @@ private:
     static inline std::atomic<bool>  s_running{false};
     static inline struct mosquitto*  s_mosq = nullptr;
     static inline std::atomic<bool>  s_initialized{false};
+    static inline std::atomic<bool>  s_offline{false};
+    static inline std::atomic<bool>  s_connected{false};
+    static inline std::atomic<std::uint64_t> s_messages{0};
 
-    // eigene DB-Instanz
-    static inline FMDatabase*        s_db = nullptr;
+    // schreibt die Events in eigenem Thread (mit eigener DB-Instanz)
+    static inline DbWriter*          s_writer = nullptr;
 };
@@ -0,0 +1,149 @@
+// active_talkers.cpp
+#include "active_talkers.h"
+
+#include <algorithm>
+#include <chrono>
+
+ActiveTalkers::ActiveTalkers(unsigned timeoutSec)
+    : timeoutSec_(std::min<unsigned>(timeoutSec, kSlots - 1)),
+      lastTick_(nowSeconds()),
+      wheel_(kSlots)
+{
+}
+
+std::uint64_t ActiveTalkers::nowSeconds()
+{
+    using namespace std::chrono;
+    return static_cast<std::uint64_t>(
+        duration_cast<seconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+void ActiveTalkers::onStart(const std::string& call,
+                            const std::string& eventTime,
+                            int tg,
+                            const std::string& server,
+                            std::uint64_t nowSec)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    Entry& e = active_[call];
+    e.talker.callsign  = call;
+    e.talker.eventTime = eventTime;
+    e.talker.tg        = tg;
+    e.talker.server    = server;
+    e.deadline         = nowSec + timeoutSec_;
+    e.gen              = nextGen_++;
+
+    wheel_[e.deadline % kSlots].push_back(WheelItem{call, e.gen});
+
+    dirty_.insert(call);
+    removed_.erase(call);
+}
+
+void ActiveTalkers::onStop(const std::string& call)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // Wheel-Eintrag bleibt liegen und wird beim Ablauf verworfen
+    if (active_.erase(call) > 0) {
+        dirty_.erase(call);
+        removed_.insert(call);
+    }
+}
+
+void ActiveTalkers::expireSlot(std::size_t slot, std::uint64_t nowSec,
+                               std::vector<std::string>* expired)
+{
+    auto& items = wheel_[slot];
+
+    std::size_t keep = 0;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        auto it = active_.find(items[i].call);
+        if (it == active_.end() || it->second.gen != items[i].gen) {
+            continue;   // veraltet (stop oder neues start)
+        }
+        if (it->second.deadline <= nowSec) {
+            dirty_.erase(items[i].call);
+            removed_.insert(items[i].call);
+            if (expired) expired->push_back(items[i].call);
+            active_.erase(it);
+            continue;
+        }
+        // gehört zu einer späteren Runde
+        if (keep != i) items[keep] = std::move(items[i]);
+        ++keep;
+    }
+    items.resize(keep);
+}
+
+void ActiveTalkers::advance(std::uint64_t nowSec, std::vector<std::string>* expired)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (nowSec <= lastTick_) return;
+
+    // nach langer Pause reicht ein Umlauf
+    std::uint64_t from = lastTick_ + 1;
+    if (nowSec - lastTick_ > kSlots) {
+        from = nowSec - kSlots + 1;
+    }
+
+    for (std::uint64_t t = from; t <= nowSec; ++t) {
+        expireSlot(static_cast<std::size_t>(t % kSlots), nowSec, expired);
+    }
+    lastTick_ = nowSec;
+}
+
+bool ActiveTalkers::takeChanges(std::vector<ActiveTalker>& upserts,
+                                std::vector<std::string>&  removals)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    upserts.clear();
+    removals.clear();
+
+    for (const auto& call : dirty_) {
+        auto it = active_.find(call);
+        if (it != active_.end()) {
+            upserts.push_back(it->second.talker);
+        }
+    }
+    removals.assign(removed_.begin(), removed_.end());
+
+    dirty_.clear();
+    removed_.clear();
+
+    return !upserts.empty() || !removals.empty();
+}
+
+void ActiveTalkers::restoreChanges(const std::vector<ActiveTalker>& upserts,
+                                   const std::vector<std::string>&  removals)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // inzwischen Geändertes hat Vorrang
+    for (const auto& t : upserts) {
+        if (active_.count(t.callsign)) dirty_.insert(t.callsign);
+    }
+    for (const auto& call : removals) {
+        if (!active_.count(call)) removed_.insert(call);
+    }
+}
+
+std::vector<ActiveTalker> ActiveTalkers::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    std::vector<ActiveTalker> out;
+    out.reserve(active_.size());
+    for (const auto& kv : active_) {
+        out.push_back(kv.second.talker);
+    }
+    return out;
+}
+
+std::size_t ActiveTalkers::size() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return active_.size();
+}
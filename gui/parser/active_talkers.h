@@ -0,0 +1,78 @@
+// active_talkers.h
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct ActiveTalker {
+    std::string callsign;
+    std::string eventTime;   // "YYYY-MM-DD HH:MM:SS" des letzten start-Events
+    int         tg = 0;
+    std::string server;
+};
+
+// Wer sendet gerade? Quelle der Wahrheit für fmstatus.
+// start -> eintragen/aktualisieren, stop -> entfernen, ohne stop läuft der
+// Eintrag nach timeoutSec ab. Für das Timeout wird ein Timer-Wheel mit
+// 1-Sekunden-Slots benutzt (alte Wheel-Einträge werden lazy verworfen).
+// Änderungen werden gesammelt und per takeChanges() nach MySQL gespiegelt.
+class ActiveTalkers {
+public:
+    explicit ActiveTalkers(unsigned timeoutSec = 180);
+
+    // nowSec: monotone Sekunden (steady_clock)
+    void onStart(const std::string& call,
+                 const std::string& eventTime,
+                 int tg,
+                 const std::string& server,
+                 std::uint64_t nowSec);
+    void onStop(const std::string& call);
+
+    // abgelaufene Einträge entfernen; expired bekommt deren Callsigns angehängt
+    void advance(std::uint64_t nowSec, std::vector<std::string>* expired = nullptr);
+
+    // Änderungen seit dem letzten Aufruf; false -> nichts zu tun
+    bool takeChanges(std::vector<ActiveTalker>& upserts,
+                     std::vector<std::string>&  removals);
+
+    // Änderungen wieder vormerken, wenn das Spiegeln fehlschlug
+    void restoreChanges(const std::vector<ActiveTalker>& upserts,
+                        const std::vector<std::string>&  removals);
+
+    std::vector<ActiveTalker> snapshot() const;
+    std::size_t size() const;
+
+    static std::uint64_t nowSeconds();
+
+private:
+    struct Entry {
+        ActiveTalker  talker;
+        std::uint64_t deadline = 0;
+        std::uint64_t gen      = 0;   // passt nicht mehr -> Wheel-Eintrag veraltet
+    };
+
+    struct WheelItem {
+        std::string   call;
+        std::uint64_t gen = 0;
+    };
+
+    static constexpr std::size_t kSlots = 256;   // > timeout, 1 Umlauf genügt
+
+    void expireSlot(std::size_t slot, std::uint64_t nowSec, std::vector<std::string>* expired);
+
+    mutable std::mutex mtx_;
+
+    unsigned      timeoutSec_;
+    std::uint64_t lastTick_ = 0;
+    std::uint64_t nextGen_  = 1;
+
+    std::unordered_map<std::string, Entry> active_;
+    std::vector<std::vector<WheelItem>>    wheel_;
+
+    std::unordered_set<std::string> dirty_;     // neu/geändert
+    std::unordered_set<std::string> removed_;   // entfernt
+};
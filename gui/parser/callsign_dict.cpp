@@ -0,0 +1,147 @@
+// callsign_dict.cpp
+#include "callsign_dict.h"
+#include "country_prefixes.h"
+
+#include <cstdio>
+#include <cstring>
+
+std::string_view CallsignDict::store(std::string_view call)
+{
+    // lange Ausreißer bekommen einen eigenen Block, der laufende bleibt aktiv
+    if (call.size() > kBlockSize / 4) {
+        s_blocks.push_back(std::make_unique<char[]>(call.size()));
+        char* p = s_blocks.back().get();
+        std::memcpy(p, call.data(), call.size());
+        return std::string_view(p, call.size());
+    }
+
+    if (!s_block || kBlockSize - s_blockUsed < call.size()) {
+        s_blocks.push_back(std::make_unique<char[]>(kBlockSize));
+        s_block     = s_blocks.back().get();
+        s_blockUsed = 0;
+    }
+
+    char* p = s_block + s_blockUsed;
+    std::memcpy(p, call.data(), call.size());
+    s_blockUsed += call.size();
+    return std::string_view(p, call.size());
+}
+
+std::array<char, 2> CallsignDict::toCode(std::string_view cc) noexcept
+{
+    if (cc.size() != 2) return {0, 0};
+    return {cc[0], cc[1]};
+}
+
+std::uint32_t CallsignDict::intern(std::string_view call)
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    if (auto it = s_ids.find(call); it != s_ids.end()) {
+        return it->second;
+    }
+
+    std::uint32_t id = static_cast<std::uint32_t>(s_names.size());
+    std::string_view sv = store(call);
+    s_names.push_back(sv);
+    s_country.push_back(toCode(CountryPrefixes::lookup(sv)));
+    s_ids.emplace(sv, id);
+    return id;
+}
+
+std::uint32_t CallsignDict::find(std::string_view call) noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    auto it = s_ids.find(call);
+    return it == s_ids.end() ? kNone : it->second;
+}
+
+std::string_view CallsignDict::name(std::uint32_t id) noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    if (id >= s_names.size()) return std::string_view();
+    return s_names[id];
+}
+
+std::string CallsignDict::country(std::uint32_t id) noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    if (id >= s_country.size() || s_country[id][0] == 0) return std::string();
+    return std::string(s_country[id].data(), 2);
+}
+
+std::string CallsignDict::countryOf(std::string_view call) noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    auto it = s_ids.find(call);
+    if (it == s_ids.end()) return CountryPrefixes::lookup(call);   // noch nicht gesehen
+
+    const auto& cc = s_country[it->second];
+    return cc[0] == 0 ? std::string() : std::string(cc.data(), 2);
+}
+
+bool CallsignDict::restore(std::uint32_t id, std::string_view call,
+                           std::string_view country)
+{
+    if (id == kNone || call.empty()) return false;
+
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    if (auto it = s_ids.find(call); it != s_ids.end()) {
+        if (it->second == id) return true;   // schon bekannt
+        std::fprintf(stderr, "[CallsignDict] %.*s: id %u in DB, %u in memory\n",
+                     static_cast<int>(call.size()), call.data(), id, it->second);
+        return false;
+    }
+    if (id < s_names.size() && !s_names[id].empty()) {
+        std::fprintf(stderr, "[CallsignDict] id %u already used for %.*s\n",
+                     id, static_cast<int>(s_names[id].size()), s_names[id].data());
+        return false;
+    }
+
+    // Lücken (gelöschte Zeilen) bleiben leer und werden nicht neu vergeben
+    if (id >= s_names.size()) {
+        s_names.resize(static_cast<std::size_t>(id) + 1);
+        s_country.resize(s_names.size());
+    }
+    std::string_view sv = store(call);
+    s_names[id]   = sv;
+    s_country[id] = CountryPrefixes::loaded() ? toCode(CountryPrefixes::lookup(sv))
+                                              : toCode(country);
+    s_ids.emplace(sv, id);
+    return true;
+}
+
+std::uint32_t CallsignDict::size() noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    return static_cast<std::uint32_t>(s_names.size());
+}
+
+std::uint32_t CallsignDict::persisted() noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    return s_persisted;
+}
+
+void CallsignDict::markPersisted(std::uint32_t upTo) noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    if (upTo > s_persisted) s_persisted = upTo;
+}
+
+bool CallsignDict::loaded() noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    return s_loaded;
+}
+
+void CallsignDict::setLoaded() noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    s_loaded = true;
+}
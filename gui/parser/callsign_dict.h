@@ -0,0 +1,80 @@
+// callsign_dict.h
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Callsign -> dichte 32-Bit-ID (0, 1, 2, ...), prozessweit.
+// Die Namen liegen in einem Arena-Speicher (Blöcke werden nie verschoben),
+// name() liefert daher string_views, die bis Prozessende gültig bleiben.
+// Statistik und QsoAggregator rechnen über Vektoren mit der ID als Index.
+// Der Ländercode (CountryPrefixes) wird einmal beim Vergeben der ID aufgelöst.
+//
+// Gespiegelt in MySQL als Tabelle callsigns (id, callsign, country_code):
+// beim ersten Connect per restore() geladen, neue IDs schreibt
+// FMDatabase::insertEvents in derselben Transaktion wie die fmlastheard-Zeilen.
+// Annahme: nur ein Prozess schreibt in eine Datenbank (sonst vergeben zwei
+// Prozesse dieselbe ID).
+class CallsignDict {
+public:
+    static constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+
+    // ID des Callsigns, neu vergeben, wenn noch unbekannt (allokiert, kann werfen)
+    static std::uint32_t intern(std::string_view call);
+
+    // kNone, wenn unbekannt
+    static std::uint32_t find(std::string_view call) noexcept;
+
+    // leer, wenn die ID nicht vergeben ist
+    static std::string_view name(std::uint32_t id) noexcept;
+
+    // Ländercode (ISO-3166 Alpha-2), "" ohne Treffer oder für unbekannte IDs
+    static std::string country(std::uint32_t id) noexcept;
+    static std::string countryOf(std::string_view call) noexcept;
+
+    // Eintrag aus der Tabelle callsigns übernehmen; false bei Widerspruch.
+    // country aus der Tabelle gilt nur ohne geladene Präfixe, sonst neu aufgelöst;
+    // allokiert wie intern(), kann werfen
+    static bool restore(std::uint32_t id, std::string_view call,
+                        std::string_view country = {});
+
+    // höchste vergebene ID + 1 (Größe für Vektoren über die IDs)
+    static std::uint32_t size() noexcept;
+
+    // IDs < persisted() stehen in der Tabelle callsigns
+    static std::uint32_t persisted() noexcept;
+    static void markPersisted(std::uint32_t upTo) noexcept;
+
+    // Tabelle wurde einmal geladen (pro Prozess)
+    static bool loaded() noexcept;
+    static void setLoaded() noexcept;
+
+private:
+    CallsignDict() = delete;
+
+    static constexpr std::size_t kBlockSize = 64 * 1024;
+
+    // Kopie von call im Arena-Speicher
+    static std::string_view store(std::string_view call);
+
+    // "DE" -> {'D','E'}, alles andere -> {0,0}
+    static std::array<char, 2> toCode(std::string_view cc) noexcept;
+
+    static inline std::mutex s_mtx;
+
+    static inline std::vector<std::unique_ptr<char[]>>            s_blocks;
+    static inline char*                                           s_block     = nullptr;   // laufender Block
+    static inline std::size_t                                     s_blockUsed = 0;
+    static inline std::vector<std::string_view>                   s_names;
+    static inline std::vector<std::array<char, 2>>                s_country;   // {0,0} = keiner
+    static inline std::unordered_map<std::string_view, std::uint32_t> s_ids;
+
+    static inline std::uint32_t s_persisted = 0;
+    static inline bool          s_loaded    = false;
+};
@@ -0,0 +1,98 @@
+// country_prefixes.cpp
+#include "country_prefixes.h"
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+int CountryPrefixes::slot(char c) noexcept
+{
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= '0' && c <= '9') return 26 + (c - '0');
+    return -1;
+}
+
+bool CountryPrefixes::load(const std::string& path) noexcept
+{
+    try {
+        std::ifstream in(path);
+        if (!in) {
+            std::fprintf(stderr, "[CountryPrefixes] cannot open %s, no country codes\n",
+                         path.c_str());
+            return false;
+        }
+
+        std::vector<Node> nodes(1);   // Wurzel
+        std::size_t entries = 0;
+        std::size_t lineNo  = 0;
+        std::string line;
+
+        while (std::getline(in, line)) {
+            ++lineNo;
+
+            std::istringstream ls(line);
+            std::string pfx, cc;
+            if (!(ls >> pfx) || pfx[0] == '#' || pfx[0] == ';') continue;
+
+            bool ok = (ls >> cc) && cc.size() == 2 &&
+                      std::isalpha(static_cast<unsigned char>(cc[0])) &&
+                      std::isalpha(static_cast<unsigned char>(cc[1]));
+            for (char c : pfx) {
+                if (slot(c) < 0) ok = false;
+            }
+            if (!ok) {
+                std::fprintf(stderr, "[CountryPrefixes] %s:%zu: ignored: %s\n",
+                             path.c_str(), lineNo, line.c_str());
+                continue;
+            }
+
+            std::uint32_t n = 0;
+            for (char c : pfx) {
+                const int s = slot(c);
+                if (nodes[n].child[s] == kNoChild) {
+                    nodes[n].child[s] = static_cast<std::uint32_t>(nodes.size());
+                    nodes.emplace_back();   // kann nodes verschieben -> erst danach indizieren
+                }
+                n = nodes[n].child[s];
+            }
+
+            // doppelte Präfixe: der letzte Eintrag gilt (wie im PHP-Array)
+            if (nodes[n].cc[0] == 0) ++entries;
+            nodes[n].cc[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(cc[0])));
+            nodes[n].cc[1] = static_cast<char>(std::toupper(static_cast<unsigned char>(cc[1])));
+        }
+
+        s_nodes.swap(nodes);
+        s_entries = entries;
+
+        std::fprintf(stderr, "[CountryPrefixes] %zu prefixes, %zu trie nodes from %s\n",
+                     s_entries, s_nodes.size(), path.c_str());
+        return true;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "[CountryPrefixes] load %s failed: %s\n", path.c_str(), e.what());
+        return false;
+    }
+}
+
+std::string CountryPrefixes::lookup(std::string_view call) noexcept
+{
+    if (s_nodes.empty()) return std::string();
+
+    std::size_t i = 0;
+    while (i < call.size() && std::isspace(static_cast<unsigned char>(call[i]))) ++i;
+
+    // längstes Präfix: den Trie entlanglaufen, letzten Code merken
+    const char*   best = nullptr;
+    std::uint32_t n    = 0;
+    for (; i < call.size(); ++i) {
+        const int s = slot(call[i]);
+        if (s < 0) break;
+        n = s_nodes[n].child[s];
+        if (n == kNoChild) break;
+        if (s_nodes[n].cc[0] != 0) best = s_nodes[n].cc;
+    }
+
+    return best ? std::string(best, 2) : std::string();
+}
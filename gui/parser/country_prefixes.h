@@ -0,0 +1,46 @@
+// country_prefixes.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Rufzeichen -> Ländercode (ISO-3166 Alpha-2) über das längste passende Präfix.
+// Die Präfixe kommen aus einer Textdatei (country_prefixes.txt, erzeugt aus
+// prefix_to_country() in api.php) und werden beim Laden zu einem Trie über
+// A-Z/0-9 kompiliert. Aufgelöst wird einmal pro Callsign in CallsignDict,
+// gespeichert in callsigns.country_code; api.php liest nur noch die Spalte.
+//
+// load() vor dem Start der Threads aufrufen, danach ist der Trie unveränderlich
+// und lookup() ohne Lock nutzbar.
+class CountryPrefixes {
+public:
+    static bool load(const std::string& path) noexcept;
+
+    // Trie wurde geladen (sonst liefert lookup() immer "")
+    static bool loaded() noexcept { return s_nodes.size() > 1; }
+
+    // Ländercode oder "" ohne Treffer; Groß-/Kleinschreibung egal,
+    // Leerzeichen am Anfang werden übersprungen
+    static std::string lookup(std::string_view call) noexcept;
+
+    static std::size_t size() noexcept { return s_entries; }
+
+private:
+    CountryPrefixes() = delete;
+
+    static constexpr int           kAlphabet = 36;  // A-Z, 0-9
+    static constexpr std::uint32_t kNoChild = 0;   // Knoten 0 ist die Wurzel
+
+    struct Node {
+        std::uint32_t child[kAlphabet] = {};
+        char          cc[2] = {0, 0};           // Code, wenn hier ein Präfix endet
+    };
+
+    // Index im Alphabet, -1 für andere Zeichen
+    static int slot(char c) noexcept;
+
+    static inline std::vector<Node> s_nodes;
+    static inline std::size_t       s_entries = 0;
+};
@@ -0,0 +1,467 @@
+// db_writer.cpp
+#include "db_writer.h"
+#include "callsign_dict.h"
+#include "fmdatabase.h"
+#include "fm_time.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// DB weg -> so lange warten bis zum nächsten Versuch aus dem Spool
+constexpr std::chrono::seconds kReplayRetry{2};
+
+} // namespace
+
+DbWriter::DbWriter(std::size_t queueCapacity,
+                   std::size_t batchSize,
+                   unsigned batchFlushMs,
+                   const std::string& spoolPath,
+                   std::size_t spoolBytes)
+    : queue_(queueCapacity),
+      batchSize_(batchSize > 0 ? batchSize : 1),
+      batchFlush_(batchFlushMs)
+{
+    batch_.reserve(batchSize_);
+
+    // startet auch ohne DB: Events gehen dann in den Spool; warmUp() läuft im
+    // Writer-Thread (Backfill kann dauern), sobald die DB erreichbar ist
+    db_ = new FMDatabase();
+
+    // Reste vom letzten Lauf werden zuerst nachgespielt
+    if (!spoolPath.empty()) {
+        spool_.open(spoolPath, spoolBytes);
+    }
+}
+
+// Caches und Aggregate aus der DB; vor dem ersten Schreiben (CallsignDict,
+// fmstatus leeren). false -> DB nicht erreichbar, später erneut
+bool DbWriter::warmUp()
+{
+    if (!db_->available()) return false;
+
+    // Duplicate-Stop-Erkennung aus dem Speicher statt per SELECT
+    db_->warmLastTalkCache();
+
+    // fmqso beim ersten Start mit der Historie aus fmlastheard füllen
+    if (!db_->backfillQsos()) {
+        std::cerr << "[DbWriter] fmqso backfill failed, Last-Heard starts empty\n";
+    }
+
+    // Last-Heard für die LiveApi, danach aus insertEvents nachgeführt
+    if (!db_->loadLastHeard(lastHeard_)) {
+        std::cerr << "[DbWriter] Last-Heard warmup failed, starting empty\n";
+    }
+
+    // fmstatus wird ab jetzt aus talkers_ gespiegelt, alte Einträge sind ungültig
+    db_->clearStatus();
+
+    // QSO-Statistik einmal aus fmlastheard aufbauen, danach laufend mitführen
+    if (!db_->scanQsoAggregates(qsos_)) {
+        std::cerr << "[DbWriter] QSO aggregates rebuild failed, starting empty\n";
+    }
+    return true;
+}
+
+// warmUp() nachholen, höchstens alle kReplayRetry; false -> DB noch nicht da
+bool DbWriter::ensureWarm()
+{
+    if (warm_) return true;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < warmRetryAt_) return false;
+
+    warm_ = warmUp();
+    if (!warm_) {
+        warmRetryAt_ = now + kReplayRetry;
+        return false;
+    }
+    std::cout << "[DbWriter] DB available, caches loaded\n";
+    return true;
+}
+
+DbWriter::~DbWriter()
+{
+    stop();
+
+    delete db_;
+    db_ = nullptr;
+}
+
+void DbWriter::start()
+{
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    thread_ = std::thread(&DbWriter::run, this);
+    std::cout << "[DbWriter] started, queue capacity " << queue_.capacity()
+              << ", batch " << batchSize_ << " events / " << batchFlush_.count() << " ms\n";
+}
+
+void DbWriter::stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    waitCv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    logCounters("stopped");
+}
+
+bool DbWriter::push(FMEvent&& ev) noexcept
+{
+    if (!queue_.tryPush(std::move(ev))) {
+        std::uint64_t d = ++drops_;
+
+        // höchstens alle 10 Sekunden melden
+        using namespace std::chrono;
+        std::int64_t nowMs = duration_cast<milliseconds>(
+            steady_clock::now().time_since_epoch()).count();
+        std::int64_t last = lastDropLogMs_.load();
+        if (nowMs - last >= 10000 &&
+            lastDropLogMs_.compare_exchange_strong(last, nowMs)) {
+            std::cerr << "[DbWriter] queue full, event dropped (drops total: " << d << ")\n";
+        }
+        return false;
+    }
+
+    ++pushed_;
+
+    std::size_t depth = queue_.size();
+    std::size_t prev  = maxDepth_.load();
+    while (depth > prev && !maxDepth_.compare_exchange_weak(prev, depth)) {
+    }
+
+    waitCv_.notify_one();
+    return true;
+}
+
+void DbWriter::run()
+{
+    using Clock = std::chrono::steady_clock;
+    FMEvent ev;
+
+    // bis dahin (und solange die DB fehlt) landen Events im Spool
+    if (!ensureWarm()) {
+        std::cerr << "[DbWriter] DB not available at start, spooling until it is\n";
+    }
+
+    for (;;) {
+        if (queue_.tryPop(ev)) {
+            process(std::move(ev));
+            if (batch_.size() >= batchSize_) {
+                flushBatch();
+                mirrorStatus();
+            }
+            continue;
+        }
+
+        // Queue leer: fmstatus nachziehen (Änderungen und Timeouts)
+        mirrorStatus();
+
+        // Queue leer: Spool nachspielen, zwischendurch wieder in die Queue schauen
+        if (replaySpool()) {
+            continue;
+        }
+
+        // Queue leer: Batch schreiben, wenn das älteste Event lange genug wartet
+        auto wait = std::chrono::milliseconds(100);
+        if (!batch_.empty()) {
+            auto age = Clock::now() - batchStart_;
+            if (age >= batchFlush_) {
+                flushBatch();
+            } else {
+                wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          batchFlush_ - age) + std::chrono::milliseconds(1));
+            }
+        }
+
+        spool_.sync();
+
+        // beim Stop sind wir jetzt fertig (Queue ist ausgelaufen),
+        // was noch im Spool liegt, wird beim nächsten Start geschrieben
+        if (!running_.load()) {
+            flushBatch();
+            mirrorStatus();
+            spool_.sync();
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(waitMtx_);
+        waitCv_.wait_for(lock, wait, [this] {
+            return queue_.size() > 0 || !running_.load();
+        });
+    }
+}
+
+void DbWriter::process(FMEvent&& ev)
+{
+    switch (ev.kind) {
+    case FMEvent::Kind::Talk:
+        // Live-Status sofort im Speicher, fmstatus wird später gespiegelt
+        if (ev.talk == "start") {
+            int tg = 0;
+            try {
+                tg = std::stoi(ev.tg);
+            } catch (...) {
+                tg = 0;
+            }
+            std::string when = FMDatabase::makeDateTime(ev.time);
+            talkers_.onStart(ev.call, when, tg, ev.server, ActiveTalkers::nowSeconds());
+
+            if (changeSink_) {
+                LiveChange c;
+                c.kind      = LiveChange::Kind::Start;
+                c.callsign  = ev.call;
+                c.tg        = tg;
+                c.server    = ev.server;
+                c.eventTime = std::move(when);
+                changeSink_(c);
+            }
+        } else if (ev.talk == "stop") {
+            talkers_.onStop(ev.call);
+            notify(LiveChange::Kind::Stop, ev.call);
+        }
+
+        if (spoolActive()) {
+            spoolBatch();
+            spoolEvent(ev);
+            break;
+        }
+
+        if (batch_.empty()) {
+            batchStart_ = std::chrono::steady_clock::now();
+        }
+        batch_.push_back(std::move(ev));
+        break;
+
+    case FMEvent::Kind::Node:
+        if (spoolActive()) {
+            spoolBatch();
+            spoolEvent(ev);
+            break;
+        }
+
+        if (!ensureWarm() ||
+            !db_->upsertNode(ev.call, ev.location, ev.locator,
+                             ev.lat, ev.lon, ev.rxFreq, ev.txFreq)) {
+            if (spool_.isOpen()) {
+                spoolEvent(ev);
+            } else {
+                std::cerr << "[DbWriter] upsertNode failed\n";
+            }
+            return;
+        }
+        lastHeard_.setLocation(ev.call, ev.location);
+        if (changeSink_) {
+            LiveChange c;
+            c.kind     = LiveChange::Kind::Node;
+            c.callsign = ev.call;
+            c.location = ev.location;
+            changeSink_(c);
+        }
+        ++written_;
+        recordLatency(ev);
+        break;
+    }
+}
+
+void DbWriter::flushBatch()
+{
+    if (batch_.empty()) return;
+
+    committedQsos_.clear();
+    if (!ensureWarm() || !db_->insertEvents(batch_, &committedQsos_)) {
+        if (spool_.isOpen()) {
+            std::cerr << "[DbWriter] insertEvents failed, " << batch_.size() << " events spooled\n";
+            spoolBatch();
+            return;
+        }
+        std::cerr << "[DbWriter] insertEvents failed, " << batch_.size() << " events lost\n";
+    } else {
+        written_ += batch_.size();
+        ++batches_;
+        aggregate(batch_);
+        lastHeard_.add(committedQsos_);
+        for (const auto& ev : batch_) {
+            recordLatency(ev);
+        }
+    }
+
+    batch_.clear();
+}
+
+// in den Spool, solange dort noch etwas liegt (Reihenfolge!) oder die Queue
+// halb voll ist (der Spool ist schneller als die DB)
+bool DbWriter::spoolActive() const noexcept
+{
+    if (!spool_.isOpen()) return false;
+    return !spool_.empty() || queue_.size() >= queue_.capacity() / 2;
+}
+
+void DbWriter::spoolEvent(const FMEvent& ev)
+{
+    if (spool_.append(ev)) {
+        ++spooled_;
+        return;
+    }
+
+    std::uint64_t d = ++spoolDrops_;
+    if (d == 1 || d % 1000 == 0) {
+        std::cerr << "[DbWriter] spool full, event lost (total: " << d << ")\n";
+    }
+}
+
+// gesammelte Talk-Events vor alles Neue in den Spool
+void DbWriter::spoolBatch()
+{
+    for (const auto& ev : batch_) {
+        spoolEvent(ev);
+    }
+    batch_.clear();
+}
+
+// ein Stück aus dem Spool in die DB; true -> es ging voran
+bool DbWriter::replaySpool()
+{
+    if (spool_.empty()) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < replayRetryAt_) return false;
+
+    if (!spool_.peek(batchSize_, replay_, replayEnds_) || replay_.empty()) {
+        return false;
+    }
+
+    if (!ensureWarm()) {
+        replayRetryAt_ = now + kReplayRetry;
+        return false;
+    }
+
+    // nur gleichartige Events am Stück, damit ein Fehler nichts halb schreibt
+    std::size_t n = 1;
+    bool ok = false;
+    if (replay_[0].kind == FMEvent::Kind::Talk) {
+        while (n < replay_.size() && replay_[n].kind == FMEvent::Kind::Talk) ++n;
+        replay_.resize(n);
+        committedQsos_.clear();
+        ok = db_->insertEvents(replay_, &committedQsos_);
+        if (ok) {
+            aggregate(replay_);
+            lastHeard_.add(committedQsos_);
+        }
+    } else {
+        const FMEvent& ev = replay_[0];
+        ok = db_->upsertNode(ev.call, ev.location, ev.locator,
+                             ev.lat, ev.lon, ev.rxFreq, ev.txFreq);
+        if (ok) lastHeard_.setLocation(ev.call, ev.location);
+    }
+
+    if (!ok) {
+        replayRetryAt_ = now + kReplayRetry;
+        if (!dbDownLogged_) {
+            std::cerr << "[DbWriter] DB not available, " << spool_.pendingEvents()
+                      << " events waiting in spool\n";
+            dbDownLogged_ = true;
+        }
+        return false;
+    }
+
+    spool_.consume(replayEnds_[n - 1]);
+    replayed_ += n;
+    written_  += n;
+
+    if (spool_.empty()) {
+        std::cout << "[DbWriter] spool replayed (" << replayed_.load() << " events total)\n";
+        dbDownLogged_ = false;
+    }
+    return true;
+}
+
+// gleiche Auswahl wie insertEvents: TG-"Callsigns" stehen nicht in fmlastheard
+void DbWriter::aggregate(const std::vector<FMEvent>& written)
+{
+    for (const auto& ev : written) {
+        if (ev.kind != FMEvent::Kind::Talk) continue;
+        if (ev.call.rfind("TG", 0) == 0) continue;
+
+        bool start = (ev.talk == "start");
+        if (!start && ev.talk != "stop") continue;
+
+        std::time_t t{};
+        if (!FmTime::parseDateTime(FMDatabase::makeDateTime(ev.time), t)) {
+            continue;
+        }
+
+        int tg = 0;
+        try {
+            tg = std::stoi(ev.tg);
+        } catch (...) {
+            tg = 0;
+        }
+
+        qsos_.onTalk(CallsignDict::intern(ev.call), start, t, tg);
+    }
+}
+
+void DbWriter::mirrorStatus()
+{
+    expired_.clear();
+    talkers_.advance(ActiveTalkers::nowSeconds(), changeSink_ ? &expired_ : nullptr);
+    for (const auto& call : expired_) {
+        notify(LiveChange::Kind::Timeout, call);
+    }
+
+    // fmstatus erst nach warmUp() (leert die Tabelle), bis dahin sammeln
+    if (!warm_ || !talkers_.takeChanges(statusUpserts_, statusRemovals_)) {
+        return;
+    }
+
+    if (!db_->syncStatus(statusUpserts_, statusRemovals_)) {
+        // beim nächsten Durchlauf erneut versuchen
+        talkers_.restoreChanges(statusUpserts_, statusRemovals_);
+    }
+}
+
+void DbWriter::notify(LiveChange::Kind kind, const std::string& call)
+{
+    if (!changeSink_) return;
+
+    LiveChange c;
+    c.kind     = kind;
+    c.callsign = call;
+    changeSink_(c);
+}
+
+void DbWriter::recordLatency(const FMEvent& ev)
+{
+    if (!latencySink_ || ev.recvNs == 0) return;
+
+    using namespace std::chrono;
+    std::uint64_t now = static_cast<std::uint64_t>(
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    latencySink_->push_back(now > ev.recvNs ? now - ev.recvNs : 0);
+}
+
+void DbWriter::logCounters(const char* reason)
+{
+    std::cout << "[DbWriter] " << reason
+              << ": pushed=" << pushed_.load()
+              << " written=" << written_.load()
+              << " batches=" << batches_.load()
+              << " drops="   << drops_.load()
+              << " spooled=" << spooled_.load()
+              << " replayed=" << replayed_.load()
+              << " spoolPending=" << spool_.pendingEvents()
+              << " depth="   << queue_.size()
+              << " maxDepth=" << maxDepth_.load()
+              << "/" << queue_.capacity() << "\n";
+}
@@ -0,0 +1,155 @@
+// db_writer.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_queue.h"
+#include "event_spool.h"
+#include "fm_event.h"
+#include "active_talkers.h"
+#include "last_heard.h"
+#include "qso_aggregator.h"
+
+class FMDatabase; // forward
+
+// Live-Änderung für den Event-Stream der LiveApi (SSE /events)
+struct LiveChange {
+    enum class Kind { Start, Stop, Timeout, Node };
+
+    Kind        kind = Kind::Start;
+    std::string callsign;
+    int         tg = 0;           // Start
+    std::string server;           // Start
+    std::string eventTime;        // Start: "YYYY-MM-DD HH:MM:SS"
+    std::string location;         // Node
+};
+
+// Eigener Thread, der Events aus der Queue holt und in die DB schreibt.
+// Der MQTT-Thread ruft nur push() auf und blockiert nie auf MySQL.
+//
+// Ist die DB weg oder die Queue halb voll, gehen die Events in den Spool
+// (spoolPath, leer = aus). Solange dort etwas liegt, wird alles hinten
+// angehängt und nur aus dem Spool in die DB geschrieben -> Reihenfolge bleibt.
+class DbWriter {
+public:
+    DbWriter(std::size_t queueCapacity,
+             std::size_t batchSize,
+             unsigned batchFlushMs,
+             const std::string& spoolPath = std::string(),
+             std::size_t spoolBytes = 0);
+    ~DbWriter();
+
+    DbWriter(const DbWriter&) = delete;
+    DbWriter& operator=(const DbWriter&) = delete;
+
+    void start();
+
+    // beendet den Thread, vorher wird die Queue komplett abgearbeitet
+    void stop();
+
+    // aus dem MQTT-Thread; false -> Queue voll, Event verworfen
+    bool push(FMEvent&& ev) noexcept;
+
+    // Benchmark: pro geschriebenem Event die Latenz Empfang -> DB in ns
+    // anhängen. Nur vom Writer-Thread beschrieben, erst nach stop() auswerten.
+    void setLatencySink(std::vector<std::uint64_t>* sink) noexcept { latencySink_ = sink; }
+
+    // start/stop/Timeout sobald talkers_ sie kennt, Node-Updates nach dem
+    // Schreiben. Aufruf im Writer-Thread -> muss schnell sein; vor start() setzen.
+    using ChangeSink = std::function<void(const LiveChange&)>;
+    void setChangeSink(ChangeSink sink) { changeSink_ = std::move(sink); }
+
+    // wer sendet gerade (Quelle für fmstatus)
+    const ActiveTalkers& activeTalkers() const noexcept { return talkers_; }
+
+    // QSO-Statistik, nachgeführt mit jedem geschriebenen Talk-Event
+    QsoAggregator& qsoAggregator() noexcept { return qsos_; }
+
+    // letzte QSOs (fmqso) und Node-Standorte, nachgeführt nach jedem COMMIT
+    const LastHeard& lastHeard() const noexcept { return lastHeard_; }
+
+    // Zähler fürs Monitoring
+    std::size_t   queueDepth()    const noexcept { return queue_.size(); }
+    std::size_t   queueCapacity() const noexcept { return queue_.capacity(); }
+    std::size_t   maxDepth()      const noexcept { return maxDepth_.load(); }
+    std::uint64_t pushed()        const noexcept { return pushed_.load(); }
+    std::uint64_t drops()         const noexcept { return drops_.load(); }
+    std::uint64_t written()       const noexcept { return written_.load(); }
+    std::uint64_t batches()       const noexcept { return batches_.load(); }
+    std::uint64_t spooled()       const noexcept { return spooled_.load(); }
+    std::uint64_t replayed()      const noexcept { return replayed_.load(); }
+
+private:
+    void run();
+    bool warmUp();
+    bool ensureWarm();
+    void process(FMEvent&& ev);
+    void flushBatch();
+    void mirrorStatus();
+    void notify(LiveChange::Kind kind, const std::string& call);
+    void logCounters(const char* reason);
+
+    bool spoolActive() const noexcept;
+    void spoolEvent(const FMEvent& ev);
+    void spoolBatch();
+    bool replaySpool();
+    void aggregate(const std::vector<FMEvent>& written);
+    void recordLatency(const FMEvent& ev);
+
+    BoundedMpscQueue<FMEvent> queue_;
+
+    // gesammelte Talk-Events (nur vom Writer-Thread benutzt)
+    std::vector<FMEvent>                  batch_;
+    std::size_t                           batchSize_;
+    std::chrono::milliseconds             batchFlush_;
+    std::chrono::steady_clock::time_point batchStart_{};
+
+    // eigene DB-Instanz; warm_ = Caches/Aggregate aus der DB geladen
+    FMDatabase* db_ = nullptr;
+    bool        warm_ = false;
+    std::chrono::steady_clock::time_point warmRetryAt_{};
+
+    // Events, die gerade nicht in die DB können
+    EventSpool                            spool_;
+    std::vector<FMEvent>                  replay_;
+    std::vector<std::uint64_t>            replayEnds_;
+    std::chrono::steady_clock::time_point replayRetryAt_{};
+    bool                                  dbDownLogged_ = false;
+
+    ActiveTalkers             talkers_;
+    QsoAggregator             qsos_;
+    LastHeard                 lastHeard_;
+    std::vector<LastHeardQso> committedQsos_;
+    std::vector<ActiveTalker> statusUpserts_;
+    std::vector<std::string>  statusRemovals_;
+    std::vector<std::string>  expired_;
+
+    ChangeSink changeSink_;
+
+    std::vector<std::uint64_t>* latencySink_ = nullptr;
+
+    std::thread             thread_;
+    std::atomic<bool>       running_{false};
+    std::mutex              waitMtx_;
+    std::condition_variable waitCv_;
+
+    std::atomic<std::size_t>   maxDepth_{0};
+    std::atomic<std::uint64_t> pushed_{0};
+    std::atomic<std::uint64_t> drops_{0};
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> batches_{0};
+    std::atomic<std::uint64_t> spooled_{0};
+    std::atomic<std::uint64_t> replayed_{0};
+    std::atomic<std::uint64_t> spoolDrops_{0};
+
+    // Drop-Meldungen nicht bei jedem Event ausgeben
+    std::atomic<std::int64_t> lastDropLogMs_{0};
+};
@@ -0,0 +1,91 @@
+// event_queue.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Begrenzte lock-freie MPSC-Queue (Ringpuffer mit Sequenznummer pro Slot).
+// Mehrere Producer dürfen tryPush() parallel aufrufen, tryPop() nur ein Consumer.
+// Die Kapazität wird auf die nächste Zweierpotenz aufgerundet.
+template <typename T>
+class BoundedMpscQueue {
+public:
+    explicit BoundedMpscQueue(std::size_t capacity)
+    {
+        std::size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+
+        mask_  = cap - 1;
+        slots_ = std::make_unique<Slot[]>(cap);
+        for (std::size_t i = 0; i < cap; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    // false -> Queue voll, v bleibt unverändert
+    bool tryPush(T&& v) noexcept
+    {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& s = slots_[pos & mask_];
+            std::size_t seq = s.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    s.value = std::move(v);
+                    s.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // false -> Queue leer
+    bool tryPop(T& out) noexcept
+    {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot& s = slots_[pos & mask_];
+        std::size_t seq = s.seq.load(std::memory_order_acquire);
+
+        if (static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1) < 0) {
+            return false;
+        }
+
+        out = std::move(s.value);
+        s.seq.store(pos + mask_ + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Näherungswert, nur für Monitoring
+    std::size_t size() const noexcept
+    {
+        std::size_t h = head_.load(std::memory_order_relaxed);
+        std::size_t t = tail_.load(std::memory_order_relaxed);
+        return h >= t ? h - t : 0;
+    }
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> seq{0};
+        T                        value{};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t             mask_ = 0;
+
+    alignas(64) std::atomic<std::size_t> head_{0};   // Producer
+    alignas(64) std::atomic<std::size_t> tail_{0};   // Consumer
+};
@@ -0,0 +1,306 @@
+// event_spool.cpp
+#include "event_spool.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'M', 'S', 'P', 'O', 'O', 'L', '1'};
+
+void putU16(std::vector<char>& b, std::uint16_t v)
+{
+    const char* p = reinterpret_cast<const char*>(&v);
+    b.insert(b.end(), p, p + sizeof(v));
+}
+
+void putDouble(std::vector<char>& b, double v)
+{
+    const char* p = reinterpret_cast<const char*>(&v);
+    b.insert(b.end(), p, p + sizeof(v));
+}
+
+void putString(std::vector<char>& b, const std::string& s)
+{
+    // Felder sind in der DB ohnehin kurz (VARCHAR <= 255)
+    std::uint16_t n = static_cast<std::uint16_t>(std::min<std::size_t>(s.size(), 0xFFFF));
+    putU16(b, n);
+    b.insert(b.end(), s.data(), s.data() + n);
+}
+
+bool getString(const char*& p, const char* e, std::string& s)
+{
+    std::uint16_t n = 0;
+    if (e - p < static_cast<std::ptrdiff_t>(sizeof(n))) return false;
+    std::memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    if (e - p < n) return false;
+    s.assign(p, n);
+    p += n;
+    return true;
+}
+
+} // namespace
+
+EventSpool::~EventSpool()
+{
+    close();
+}
+
+bool EventSpool::open(const std::string& path, std::size_t maxBytes) noexcept
+{
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+    if (fd_ < 0) {
+        std::cerr << "[EventSpool] cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd_, &st) != 0) {
+        std::cerr << "[EventSpool] fstat failed: " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+
+    // vorhandene Datei behält ihre Größe, sonst gingen gespoolte Events verloren
+    bool fresh = st.st_size < static_cast<off_t>(sizeof(Header));
+    std::size_t size = fresh ? std::max<std::size_t>(maxBytes, kDataStart + 4096)
+                             : static_cast<std::size_t>(st.st_size);
+
+    if (fresh && ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        std::cerr << "[EventSpool] ftruncate failed: " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+
+    void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (m == MAP_FAILED) {
+        std::cerr << "[EventSpool] mmap failed: " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+    base_ = static_cast<char*>(m);
+    size_ = size;
+
+    Header* h = header();
+
+    // Absturz beim Zurücksetzen in consume() (tail schon vorne, head noch nicht)
+    if (!fresh && h->tail == kDataStart) {
+        h->head = kDataStart;
+    }
+
+    bool valid = !fresh &&
+                 std::memcmp(h->magic, kMagic, sizeof(kMagic)) == 0 &&
+                 h->size == size_ &&
+                 h->head >= kDataStart && h->head <= h->tail && h->tail <= size_;
+
+    if (!valid) {
+        if (!fresh) {
+            std::cerr << "[EventSpool] " << path << " has an invalid header, starting empty\n";
+        }
+        std::memcpy(h->magic, kMagic, sizeof(kMagic));
+        h->size   = size_;
+        h->head   = kDataStart;
+        h->tail   = kDataStart;
+        h->events = 0;
+        dirty_ = true;
+        sync();
+        return true;
+    }
+
+    // Zähler neu bestimmen (kann nach einem Absturz um eins daneben liegen)
+    std::uint64_t n = 0;
+    std::uint64_t pos = h->head;
+    while (pos + sizeof(std::uint32_t) <= h->tail) {
+        std::uint32_t len = 0;
+        std::memcpy(&len, base_ + pos, sizeof(len));
+        if (len == 0 || pos + sizeof(len) + len > h->tail) break;
+        pos += sizeof(len) + len;
+        ++n;
+    }
+    if (pos != h->tail) {
+        std::cerr << "[EventSpool] truncated record at end of spool, ignored\n";
+        h->tail = pos;
+    }
+    h->events = n;
+
+    if (n > 0) {
+        std::cout << "[EventSpool] " << n << " spooled events from last run pending\n";
+    }
+    return true;
+}
+
+void EventSpool::close() noexcept
+{
+    if (base_) {
+        msync(base_, size_, MS_SYNC);
+        munmap(base_, size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool EventSpool::empty() const noexcept
+{
+    return !isOpen() || header()->head == header()->tail;
+}
+
+std::uint64_t EventSpool::pendingBytes() const noexcept
+{
+    return isOpen() ? header()->tail - header()->head : 0;
+}
+
+void EventSpool::encode(const FMEvent& ev, std::vector<char>& b)
+{
+    b.clear();
+    b.push_back(static_cast<char>(ev.kind));
+    putDouble(b, ev.lat);
+    putDouble(b, ev.lon);
+    putString(b, ev.call);
+    putString(b, ev.time);
+    putString(b, ev.talk);
+    putString(b, ev.tg);
+    putString(b, ev.server);
+    putString(b, ev.location);
+    putString(b, ev.locator);
+    putString(b, ev.rxFreq);
+    putString(b, ev.txFreq);
+}
+
+bool EventSpool::decode(const char* p, std::size_t len, FMEvent& ev)
+{
+    const char* e = p + len;
+    if (len < 1 + 2 * sizeof(double)) return false;
+
+    std::uint8_t kind = static_cast<std::uint8_t>(*p++);
+    if (kind > static_cast<std::uint8_t>(FMEvent::Kind::Node)) return false;
+    ev.kind = static_cast<FMEvent::Kind>(kind);
+
+    std::memcpy(&ev.lat, p, sizeof(double)); p += sizeof(double);
+    std::memcpy(&ev.lon, p, sizeof(double)); p += sizeof(double);
+
+    ev.recvNs = 0;   // Latenz ist hier nicht mehr sinnvoll
+    return getString(p, e, ev.call) &&
+           getString(p, e, ev.time) &&
+           getString(p, e, ev.talk) &&
+           getString(p, e, ev.tg) &&
+           getString(p, e, ev.server) &&
+           getString(p, e, ev.location) &&
+           getString(p, e, ev.locator) &&
+           getString(p, e, ev.rxFreq) &&
+           getString(p, e, ev.txFreq) &&
+           p == e;
+}
+
+bool EventSpool::append(const FMEvent& ev) noexcept
+{
+    if (!isOpen()) return false;
+
+    try {
+        encode(ev, buf_);
+    } catch (...) {
+        return false;
+    }
+
+    Header* h = header();
+    std::uint32_t len = static_cast<std::uint32_t>(buf_.size());
+    if (h->tail + sizeof(len) + len > size_) {
+        return false;   // voll, Platz gibt es erst wieder, wenn alles nachgespielt ist
+    }
+
+    std::memcpy(base_ + h->tail, &len, sizeof(len));
+    std::memcpy(base_ + h->tail + sizeof(len), buf_.data(), len);
+
+    // erst jetzt gilt der Record
+    h->tail += sizeof(len) + len;
+    ++h->events;
+    dirty_ = true;
+    return true;
+}
+
+bool EventSpool::peek(std::size_t maxEvents,
+                      std::vector<FMEvent>& out,
+                      std::vector<std::uint64_t>& ends) noexcept
+{
+    out.clear();
+    ends.clear();
+    if (!isOpen()) return false;
+
+    const Header* h = header();
+    std::uint64_t pos = h->head;
+
+    try {
+        while (out.size() < maxEvents && pos + sizeof(std::uint32_t) <= h->tail) {
+            std::uint32_t len = 0;
+            std::memcpy(&len, base_ + pos, sizeof(len));
+
+            FMEvent ev;
+            if (len == 0 || pos + sizeof(len) + len > h->tail ||
+                !decode(base_ + pos + sizeof(len), len, ev)) {
+                // kaputt -> Rest verwerfen, sonst hängt der Writer hier fest
+                // (erst wenn die gültigen Events davor geschrieben sind)
+                if (out.empty()) {
+                    std::cerr << "[EventSpool] corrupt record, dropping "
+                              << (h->tail - pos) << " bytes\n";
+                    consume(h->tail);
+                }
+                break;
+            }
+            out.push_back(std::move(ev));
+            pos += sizeof(len) + len;
+            ends.push_back(pos);
+        }
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+void EventSpool::consume(std::uint64_t newHead) noexcept
+{
+    if (!isOpen()) return;
+
+    Header* h = header();
+    if (newHead <= h->head || newHead > h->tail) return;
+
+    // Events zählen, die übersprungen werden
+    std::uint64_t pos = h->head;
+    std::uint64_t n = 0;
+    while (pos < newHead) {
+        std::uint32_t len = 0;
+        std::memcpy(&len, base_ + pos, sizeof(len));
+        if (len == 0 || pos + sizeof(len) + len > newHead) break;
+        pos += sizeof(len) + len;
+        ++n;
+    }
+    h->events = h->events > n ? h->events - n : 0;
+
+    if (newHead == h->tail) {
+        // alles nachgespielt -> wieder vorne anfangen (tail zuerst, siehe open())
+        h->tail   = kDataStart;
+        h->head   = kDataStart;
+        h->events = 0;
+    } else {
+        h->head = newHead;
+    }
+    dirty_ = true;
+}
+
+void EventSpool::sync() noexcept
+{
+    if (!isOpen() || !dirty_) return;
+    msync(base_, size_, MS_ASYNC);
+    dirty_ = false;
+}
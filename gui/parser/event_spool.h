@@ -0,0 +1,82 @@
+// event_spool.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fm_event.h"
+
+// Append-only Spool-Datei (mmap) für Events, die gerade nicht in die DB können:
+// DB weg (z.B. MariaDB-Neustart beim apt upgrade) oder Writer kommt nicht hinterher.
+// Überlebt Neustarts von FMparser; beim Start wird der Rest nachgespielt.
+//
+// Wird nur vom DB-Writer-Thread benutzt (ein Schreiber, ein Leser) -> kein Lock.
+// Reihenfolge = Reihenfolge von append(), damit bleibt auch die Reihenfolge
+// je Callsign erhalten.
+//
+// Layout: Header (Magic, Größe, head, tail), danach Records ab kDataStart:
+//   u32 Länge, Kind, lat, lon, 9 Strings (u16 Länge + Bytes)
+// head = nächster nicht geschriebener Record, tail = Ende der gültigen Daten.
+// tail wird erst nach dem Record geschrieben, head erst nach dem COMMIT
+// (Absturz dazwischen -> Events werden doppelt eingefügt, nicht verloren).
+// Ist alles nachgespielt, beginnt die Datei wieder vorne.
+class EventSpool {
+public:
+    EventSpool() = default;
+    ~EventSpool();
+
+    EventSpool(const EventSpool&) = delete;
+    EventSpool& operator=(const EventSpool&) = delete;
+
+    // Datei anlegen oder vorhandene übernehmen; maxBytes = feste Dateigröße
+    bool open(const std::string& path, std::size_t maxBytes) noexcept;
+    void close() noexcept;
+
+    bool isOpen() const noexcept { return base_ != nullptr; }
+    bool empty()  const noexcept;
+
+    // false -> Spool voll (oder nicht offen)
+    bool append(const FMEvent& ev) noexcept;
+
+    // bis zu maxEvents Events ab head lesen, ohne head zu verschieben;
+    // ends[i] = Position hinter Event i (für consume)
+    bool peek(std::size_t maxEvents,
+              std::vector<FMEvent>& out,
+              std::vector<std::uint64_t>& ends) noexcept;
+
+    // Events bis newHead (aus ends) sind in der DB
+    void consume(std::uint64_t newHead) noexcept;
+
+    // Seiten anstoßen (MS_ASYNC), überlebt dann auch einen Absturz des Rechners eher
+    void sync() noexcept;
+
+    std::uint64_t pendingBytes()  const noexcept;
+    std::uint64_t pendingEvents() const noexcept { return isOpen() ? header()->events : 0; }
+
+private:
+    struct Header {
+        char          magic[8];
+        std::uint64_t size;
+        std::uint64_t head;
+        std::uint64_t tail;
+        std::uint64_t events;   // Anzahl Events zwischen head und tail
+    };
+
+    static constexpr std::uint64_t kDataStart = 64;
+
+    Header*       header()       noexcept { return reinterpret_cast<Header*>(base_); }
+    const Header* header() const noexcept { return reinterpret_cast<const Header*>(base_); }
+
+    static void encode(const FMEvent& ev, std::vector<char>& buf);
+    static bool decode(const char* p, std::size_t len, FMEvent& ev);
+
+    int         fd_   = -1;
+    char*       base_ = nullptr;
+    std::size_t size_ = 0;
+    bool        dirty_ = false;
+
+    std::vector<char> buf_;   // Serialisierungspuffer, wiederverwendet
+};
@@ -0,0 +1,35 @@
+// fm_event.h
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <limits>
+
+// Ein MQTT-Event, wie es vom MQTT-Thread an den DB-Writer übergeben wird
+struct FMEvent {
+    enum class Kind : std::uint8_t {
+        Talk,   // /server/statethr/...
+        Node    // /server/state/nodes/...
+    };
+
+    Kind kind = Kind::Talk;
+
+    std::string call;
+
+    // Talk
+    std::string time;
+    std::string talk;
+    std::string tg;
+    std::string server;
+
+    // Node
+    std::string location;
+    std::string locator;
+    std::string rxFreq;
+    std::string txFreq;
+    double      lat = std::numeric_limits<double>::quiet_NaN();
+    double      lon = std::numeric_limits<double>::quiet_NaN();
+
+    // Empfangszeit (steady_clock, ns) für die Latenzmessung im Replay
+    std::uint64_t recvNs = 0;
+};
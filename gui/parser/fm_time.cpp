@@ -0,0 +1,186 @@
+// fm_time.cpp
+#include "fm_time.h"
+
+#include <array>
+#include <cstdio>
+
+namespace {
+
+constexpr std::int64_t kDay = 24 * 60 * 60;
+
+std::int64_t floorDiv(std::int64_t a, std::int64_t b) noexcept
+{
+    std::int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+long probeOffset(std::time_t t) noexcept
+{
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    return tm.tm_gmtoff;
+}
+
+// ein UTC-Tag: Offset am Anfang, ab switchAt der zweite (bei Umstellung)
+struct DayOffsets {
+    std::int64_t day      = 0;
+    std::time_t  switchAt = 0;
+    long         offA     = 0;
+    long         offB     = 0;
+    bool         valid    = false;
+};
+
+constexpr std::size_t kSlots = 64;   // direkt adressiert über day % 64
+thread_local std::array<DayOffsets, kSlots> t_offsets{};
+
+struct Prefix {
+    std::time_t sec = -1;
+    char        buf[12] = {};
+};
+thread_local Prefix t_prefix;
+
+inline bool digits(std::string_view s, std::size_t pos, std::size_t n, int& out) noexcept
+{
+    int v = 0;
+    for (std::size_t i = pos; i < pos + n; ++i) {
+        char c = s[i];
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + (c - '0');
+    }
+    out = v;
+    return true;
+}
+
+} // namespace
+
+std::int64_t FmTime::daysFromCivil(int y, unsigned m, unsigned d) noexcept
+{
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+void FmTime::civilFromDays(std::int64_t z, int& y, unsigned& m, unsigned& d) noexcept
+{
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp  = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2));
+}
+
+long FmTime::utcOffset(std::time_t t) noexcept
+{
+    const std::int64_t day = floorDiv(static_cast<std::int64_t>(t), kDay);
+    DayOffsets& e = t_offsets[static_cast<std::size_t>(day & (kSlots - 1))];
+
+    if (!e.valid || e.day != day) {
+        const std::time_t first = static_cast<std::time_t>(day * kDay);
+        const std::time_t last  = first + kDay - 1;
+
+        e.day      = day;
+        e.offA     = probeOffset(first);
+        e.offB     = probeOffset(last);
+        e.switchAt = last + 1;
+        e.valid    = true;
+
+        if (e.offA != e.offB) {
+            // Umstellung an diesem Tag: erste Sekunde mit neuem Offset suchen
+            std::time_t lo = first, hi = last;
+            while (hi - lo > 1) {
+                std::time_t mid = lo + (hi - lo) / 2;
+                if (probeOffset(mid) == e.offA) lo = mid; else hi = mid;
+            }
+            e.switchAt = hi;
+        }
+    }
+
+    return t < e.switchAt ? e.offA : e.offB;
+}
+
+bool FmTime::parseDateTime(std::string_view s, std::time_t& out) noexcept
+{
+    // YYYY-MM-DD HH:MM:SS
+    if (s.size() != 19 || s[4] != '-' || s[7] != '-' || s[10] != ' ' ||
+        s[13] != ':' || s[16] != ':') {
+        return false;
+    }
+
+    int y, mo, d, h, mi, se;
+    if (!digits(s, 0, 4, y) || !digits(s, 5, 2, mo) || !digits(s, 8, 2, d) ||
+        !digits(s, 11, 2, h) || !digits(s, 14, 2, mi) || !digits(s, 17, 2, se)) {
+        return false;
+    }
+    if (mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || se > 60) {
+        return false;
+    }
+
+    // lokale Sekunden, als wäre es UTC
+    const std::int64_t local = daysFromCivil(y, static_cast<unsigned>(mo), static_cast<unsigned>(d)) * kDay
+                             + h * 3600 + mi * 60 + se;
+
+    // Offset hängt vom UTC-Zeitpunkt ab: Kandidaten mit dem Offset von
+    // gestern und von "jetzt" prüfen. Doppelte Stunde (Ende Sommerzeit) ->
+    // die frühere, Lücke (Beginn Sommerzeit) -> wie mktime mit isdst=-1
+    const long oPrev = utcOffset(static_cast<std::time_t>(local - kDay));
+    const long oNow  = utcOffset(static_cast<std::time_t>(local));
+
+    std::time_t u = 0;
+    bool found = false;
+    for (long o : {oPrev, oNow}) {
+        std::time_t c = static_cast<std::time_t>(local - o);
+        if (utcOffset(c) == o && (!found || c < u)) {
+            u = c;
+            found = true;
+        }
+    }
+    if (!found) {
+        u = static_cast<std::time_t>(local - oNow);
+        const long o2 = utcOffset(u);
+        if (o2 != oNow) u = static_cast<std::time_t>(local - o2);
+    }
+
+    out = u;
+    return true;
+}
+
+std::int64_t FmTime::localDay(std::time_t t, int* hour) noexcept
+{
+    const std::int64_t local = static_cast<std::int64_t>(t) + utcOffset(t);
+    const std::int64_t day   = floorDiv(local, kDay);
+    if (hour) *hour = static_cast<int>((local - day * kDay) / 3600);
+    return day;
+}
+
+int FmTime::weekday(std::int64_t day) noexcept
+{
+    // 1970-01-01 war ein Donnerstag
+    return static_cast<int>(((day + 3) % 7 + 7) % 7);
+}
+
+void FmTime::formatDay(std::int64_t day, char* buf) noexcept
+{
+    int y;
+    unsigned m, d;
+    civilFromDays(day, y, m, d);
+    std::snprintf(buf, 11, "%04d-%02u-%02u", y, m, d);
+}
+
+std::string_view FmTime::todayPrefix() noexcept
+{
+    std::time_t now = std::time(nullptr);
+    if (now != t_prefix.sec) {
+        formatDay(localDay(now), t_prefix.buf);
+        t_prefix.buf[10] = ' ';
+        t_prefix.buf[11] = '\0';
+        t_prefix.sec = now;
+    }
+    return std::string_view(t_prefix.buf, 11);
+}
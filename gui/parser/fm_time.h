@@ -0,0 +1,39 @@
+// fm_time.h
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+// Zeit-Helfer für die heißen Pfade (Ingest, Statistik-Scan).
+// Ohne istringstream/get_time/mktime: Datumswerte werden von Hand gelesen,
+// lokale Zeit kommt aus einer Tabelle der UTC-Offsets je UTC-Tag
+// (inkl. Sommerzeit-Umstellung innerhalb eines Tages). localtime_r und damit
+// das globale Zeitzonen-Lock gibt es nur beim ersten Zugriff auf einen Tag.
+// Cache ist thread_local -> keine Locks zwischen Writer- und main-Thread.
+class FmTime {
+public:
+    // Offset lokale Zeit - UTC in Sekunden zum Zeitpunkt t
+    static long utcOffset(std::time_t t) noexcept;
+
+    // "YYYY-MM-DD HH:MM:SS" (lokale Zeit) -> time_t; false bei anderem Format
+    static bool parseDateTime(std::string_view s, std::time_t& out) noexcept;
+
+    // lokaler Tag (Tage seit 1970-01-01), optional mit Stunde 0..23
+    static std::int64_t localDay(std::time_t t, int* hour = nullptr) noexcept;
+
+    // 0=Montag..6=Sonntag für einen Tag aus localDay()
+    static int weekday(std::int64_t day) noexcept;
+
+    // "YYYY-MM-DD" in buf (mind. 11 Byte, nullterminiert)
+    static void formatDay(std::int64_t day, char* buf) noexcept;
+
+    // "YYYY-MM-DD " von heute (lokal), pro Sekunde gecacht
+    static std::string_view todayPrefix() noexcept;
+
+    static std::int64_t daysFromCivil(int y, unsigned m, unsigned d) noexcept;
+    static void civilFromDays(std::int64_t z, int& y, unsigned& m, unsigned& d) noexcept;
+
+private:
+    FmTime() = delete;
+};
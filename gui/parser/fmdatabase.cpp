@@ -1,7 +1,11 @@
 // fmdatabase.cpp
 #include "fmdatabase.h"
+#include "callsign_dict.h"
+#include "fm_time.h"
+#include "top_k.h"
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <cmath>
 #include <ctime>
@@ -12,56 +16,249 @@
 #include <unordered_map>
 #include <algorithm>
 #include <tuple>
+#include <type_traits>
 #include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <sys/resource.h>
+#include <mysql/errmsg.h>
+#include <mysql/mysqld_error.h>
+
+namespace {
+
+// kleine Helfer zum Befüllen von MYSQL_BIND (Puffer müssen bis execute leben)
+void bindString(MYSQL_BIND& b, const std::string& s, unsigned long& len)
+{
+    std::memset(&b, 0, sizeof(b));
+    len             = static_cast<unsigned long>(s.size());
+    b.buffer_type   = MYSQL_TYPE_STRING;
+    b.buffer        = const_cast<char*>(s.data());
+    b.buffer_length = len;
+    b.length        = &len;
+}
+
+void bindInt(MYSQL_BIND& b, const int& v)
+{
+    std::memset(&b, 0, sizeof(b));
+    b.buffer_type = MYSQL_TYPE_LONG;
+    b.buffer      = const_cast<int*>(&v);
+}
+
+void bindUInt64(MYSQL_BIND& b, const std::uint64_t& v)
+{
+    std::memset(&b, 0, sizeof(b));
+    b.buffer_type = MYSQL_TYPE_LONGLONG;
+    b.buffer      = const_cast<std::uint64_t*>(&v);
+    b.is_unsigned = true;
+}
+
+void bindDouble(MYSQL_BIND& b, const double& v)
+{
+    std::memset(&b, 0, sizeof(b));
+    b.buffer_type = MYSQL_TYPE_DOUBLE;
+    b.buffer      = const_cast<double*>(&v);
+}
+
+void bindNull(MYSQL_BIND& b)
+{
+    std::memset(&b, 0, sizeof(b));
+    b.buffer_type = MYSQL_TYPE_NULL;
+}
+
+// Literale für zusammengesetzte INSERTs (fmstats), NULL bei nullptr
+void appendSqlInt(std::string& sql, const int* v)
+{
+    sql += v ? std::to_string(*v) : std::string("NULL");
+}
+
+void appendSqlDouble(std::string& sql, const double* v)
+{
+    if (!v || !std::isfinite(*v)) {
+        sql += "NULL";
+        return;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.17g", *v);
+    sql += buf;
+}
+
+// Mehrzeilige INSERTs werden in Blöcke dieser Größen zerlegt,
+// damit nur wenige Statements vorbereitet werden müssen
+constexpr std::size_t kHeardChunks[] = {64, 16, 4, 1};
+
+std::string makeHeardInsertSql(std::size_t rows)
+{
+    std::string q = "INSERT INTO fmlastheard (event_time, talk, callsign, callsign_id, tg, server) VALUES ";
+    for (std::size_t i = 0; i < rows; ++i) {
+        if (i) q += ",";
+        q += "(?,?,?,?,?,?)";
+    }
+    return q;
+}
+
+std::string makeQsoInsertSql(std::size_t rows)
+{
+    std::string q = "INSERT INTO fmqso "
+                    "(callsign, callsign_id, tg, server, start_time, end_time, duration_s) VALUES ";
+    for (std::size_t i = 0; i < rows; ++i) {
+        if (i) q += ",";
+        q += "(?,?,?,?,?,?,?)";
+    }
+    return q;
+}
+
+// SvxLink MONITOR_TGS: "1,2++,262" -> {1, 2, 262} ('+' = Priorität, hier egal)
+std::vector<int> parseTgList(const char* s)
+{
+    std::vector<int> out;
+    while (*s) {
+        char* end = nullptr;
+        long v = std::strtol(s, &end, 10);
+        if (end != s && v > 0) {
+            out.push_back(static_cast<int>(v));
+        }
+        s = (end != s) ? end : s + 1;
+        while (*s && *s != ',') ++s;
+        if (*s == ',') ++s;
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+// Vollscan für scanQsoAggregates, Shard shard von shards (1 = alles).
+// DATETIME kommt als "YYYY-MM-DD HH:MM:SS" -> FmTime::parseDateTime;
+// Callsign als ID, den Namen nur für alte Zeilen ohne callsign_id
+std::string makeScanSql(const char* cutoff, unsigned shards, unsigned shard)
+{
+    std::ostringstream oss;
+    oss << "SELECT event_time, talk, callsign_id, IF(callsign_id IS NULL, callsign, NULL), tg "
+           "FROM fmlastheard "
+           "WHERE event_time >= '" << cutoff << " 00:00:00' ";
+    if (shards > 1) {
+        oss << "AND CRC32(callsign) % " << shards << " = " << shard << " ";
+    }
+    oss << "ORDER BY callsign, event_time, id";
+    return oss.str();
+}
+
+// eine Zeile aus makeScanSql (dieselbe start/stop-Logik wie beim Schreiben,
+// QsoAggregator::onTalk)
+void scanRow(QsoAggregator& out, MYSQL_ROW row)
+{
+    const char* etStr = row[0];
+    const char* talk  = row[1];
+    const char* idStr = row[2];
+    const char* call  = row[3];
+    const char* tgStr = row[4];
+
+    if (!etStr || !talk || (!idStr && !call) || !tgStr) {
+        return;
+    }
+
+    std::time_t t{};
+    if (!FmTime::parseDateTime(etStr, t)) {
+        return;
+    }
+
+    std::uint32_t callId = idStr
+        ? static_cast<std::uint32_t>(std::strtoul(idStr, nullptr, 10))
+        : CallsignDict::intern(call);
+
+    if (std::strcmp(talk, "start") == 0) {
+        out.onTalk(callId, true, t, std::atoi(tgStr));
+    } else if (std::strcmp(talk, "stop") == 0) {
+        out.onTalk(callId, false, t, std::atoi(tgStr));
+    }
+}
+
+} // namespace
 
 FMDatabase::FMDatabase()
 {
-    if (!connect()) {
-        std::fprintf(stderr, "[FMDB] initial connect() failed: %s\n", lastError_.c_str());
-        std::exit(EXIT_FAILURE);
+    // DB nicht erreichbar (z.B. MariaDB-Neustart beim apt upgrade): ohne
+    // Verbindung weiter, ensureConn() versucht es bei jedem Aufruf erneut
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!connectLocked()) {
+        std::fprintf(stderr, "[FMDB] initial connect failed: %s, retrying later\n",
+                     lastError_.c_str());
     }
 }
 
 FMDatabase::~FMDatabase()
 {
     std::lock_guard<std::mutex> lock(mtx_);
+    closeStatements();
     if (conn_) {
         mysql_close(conn_);
         conn_ = nullptr;
     }
 }
 
-bool FMDatabase::connect() noexcept
+bool FMDatabase::connectLocked() noexcept
 {
-    std::lock_guard<std::mutex> lock(mtx_);
-
     lastError_.clear();
 
+    // Statements gehören zur alten Verbindung
+    closeStatements();
+
     if (conn_) {
         mysql_close(conn_);
         conn_ = nullptr;
     }
 
-    conn_ = mysql_init(nullptr);
+    conn_ = openConnection(lastError_);
     if (!conn_) {
-        lastError_ = "mysql_init failed";
-        std::fprintf(stderr, "[FMDB] %s\n", lastError_.c_str());
         return false;
     }
 
+    // halb eingerichtete Verbindung verwerfen, sonst hielte ensureConn() sie
+    // per ping für gut und Schema/CallsignDict würden nie nachgeholt
+    auto fail = [this](const char* what) {
+        std::fprintf(stderr, "[FMDB] %s failed: %s\n", what, lastError_.c_str());
+        closeStatements();
+        mysql_close(conn_);
+        conn_ = nullptr;
+        return false;
+    };
+
+    if (!ensureSchema()) {
+        return fail("ensureSchema");
+    }
+
+    // einmal pro Prozess, bevor die erste ID vergeben wird
+    if (!CallsignDict::loaded() && !loadCallsigns()) {
+        return fail("loadCallsigns");
+    }
+
+    return true;
+}
+
+MYSQL* FMDatabase::openConnection(std::string& err) const noexcept
+{
+    MYSQL* c = mysql_init(nullptr);
+    if (!c) {
+        err = "mysql_init failed";
+        std::fprintf(stderr, "[FMDB] %s\n", err.c_str());
+        return nullptr;
+    }
+
     // Auto-Reconnect
     {
         bool rc = true;
-        mysql_options(conn_, MYSQL_OPT_RECONNECT, &rc);
+        mysql_options(c, MYSQL_OPT_RECONNECT, &rc);
     }
 
     // Unix-Socket forcieren (optional)
     {
         unsigned int proto = MYSQL_PROTOCOL_SOCKET;
-        mysql_options(conn_, MYSQL_OPT_PROTOCOL, &proto);
+        mysql_options(c, MYSQL_OPT_PROTOCOL, &proto);
     }
 
-    if (!mysql_real_connect(conn_,
+    if (!mysql_real_connect(c,
                             nullptr,                   // host (nullptr = lokal)
                             dbUser_.c_str(),
                             dbPass_.c_str(),
@@ -69,19 +266,12 @@ bool FMDatabase::connect() noexcept
                             dbPort_,
                             dbUnixSocket_.c_str(),
                             0)) {
-        lastError_ = mysql_error(conn_);
-        std::fprintf(stderr, "[FMDB] mysql_real_connect failed: %s\n", lastError_.c_str());
-        mysql_close(conn_);
-        conn_ = nullptr;
-        return false;
-    }
-
-    if (!ensureSchema()) {
-        std::fprintf(stderr, "[FMDB] ensureSchema failed: %s\n", lastError_.c_str());
-        return false;
+        err = mysql_error(c);
+        std::fprintf(stderr, "[FMDB] mysql_real_connect failed: %s\n", err.c_str());
+        mysql_close(c);
+        return nullptr;
     }
-
-    return true;
+    return c;
 }
 
 bool FMDatabase::ensureSchema() noexcept
@@ -98,11 +288,13 @@ bool FMDatabase::ensureSchema() noexcept
         "  event_time DATETIME NOT NULL,"
         "  talk       VARCHAR(8)  NOT NULL,"       // 'start' / 'stop'
         "  callsign   VARCHAR(32) NOT NULL,"
+        "  callsign_id INT UNSIGNED NULL,"         // -> callsigns.id
         "  tg         INT         NOT NULL,"
         "  server     VARCHAR(8)  NOT NULL,"
         "  created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,"
         "  INDEX idx_event_time (event_time),"
         "  INDEX idx_callsign   (callsign),"
+        "  INDEX idx_callsign_id (callsign_id),"
         "  INDEX idx_tg         (tg)"
         ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;";
 
@@ -112,6 +304,115 @@ bool FMDatabase::ensureSchema() noexcept
         return false;
     }
 
+    // ältere Installationen: Spalte nachrüsten (alte Zeilen bleiben NULL)
+    static const char* q1a =
+        "ALTER TABLE fmlastheard "
+        "  ADD COLUMN IF NOT EXISTS callsign_id INT UNSIGNED NULL AFTER callsign,"
+        "  ADD INDEX IF NOT EXISTS idx_callsign_id (callsign_id)";
+
+    if (mysql_query(conn_, q1a) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] alter fmlastheard failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    // callsigns: Spiegel des CallsignDict (dichte IDs ab 0). Binär verglichen wie
+    // im CallsignDict: "dl1abc" und "DL1ABC" sind dort zwei IDs und damit zwei Zeilen
+    static const char* q1b =
+        "CREATE TABLE IF NOT EXISTS callsigns ("
+        "  id       INT UNSIGNED NOT NULL PRIMARY KEY,"
+        "  callsign VARCHAR(32) CHARACTER SET utf8mb4 COLLATE utf8mb4_bin NOT NULL,"
+        "  UNIQUE INDEX idx_callsign (callsign)"
+        ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;";
+
+    if (mysql_query(conn_, q1b) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] create callsigns failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    // ältere Tabellen hatten utf8mb4_general_ci: dort hat INSERT IGNORE Callsigns,
+    // die sich nur in Groß-/Kleinschreibung unterscheiden, verworfen -> umstellen
+    // und die fehlenden Namen aus fmlastheard nachtragen
+    std::string collation;
+    if (!queryValue("SELECT COLLATION_NAME FROM information_schema.COLUMNS "
+                    "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'callsigns' "
+                    "AND COLUMN_NAME = 'callsign'", collation)) {
+        std::fprintf(stderr, "[FMDB] callsigns collation query failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    if (!collation.empty() && collation != "utf8mb4_bin") {
+        static const char* q1bb =
+            "ALTER TABLE callsigns MODIFY callsign "
+            "  VARCHAR(32) CHARACTER SET utf8mb4 COLLATE utf8mb4_bin NOT NULL";
+        static const char* q1bc =
+            "INSERT INTO callsigns (id, callsign) "
+            "SELECT h.callsign_id, MIN(h.callsign) FROM fmlastheard h "
+            "LEFT JOIN callsigns c ON c.id = h.callsign_id "
+            "WHERE h.callsign_id IS NOT NULL AND c.id IS NULL "
+            "GROUP BY h.callsign_id";
+
+        if (mysql_query(conn_, q1bb) != 0 || mysql_query(conn_, q1bc) != 0) {
+            lastError_ = mysql_error(conn_);
+            std::fprintf(stderr, "[FMDB] callsigns collation migration failed: %s\n",
+                         lastError_.c_str());
+            return false;
+        }
+        std::fprintf(stdout, "[FMDB] callsigns: collation %s -> utf8mb4_bin, %llu names restored\n",
+                     collation.c_str(),
+                     static_cast<unsigned long long>(mysql_affected_rows(conn_)));
+    }
+
+    // Ländercode je Callsign (CountryPrefixes), api.php liest nur diese Spalte;
+    // alte Zeilen füllt loadCallsigns() nach
+    static const char* q1ba =
+        "ALTER TABLE callsigns "
+        "  ADD COLUMN IF NOT EXISTS country_code CHAR(2) NULL AFTER callsign";
+
+    if (mysql_query(conn_, q1ba) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] alter callsigns failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    // fmqso: abgeschlossene QSOs (stop + passender start), beim Schreiben gepaart;
+    // Last-Heard und Auswertungen lesen hier per Range über end_time
+    static const char* q1c = R"SQL(
+        CREATE TABLE IF NOT EXISTS fmqso (
+          id          BIGINT UNSIGNED NOT NULL AUTO_INCREMENT PRIMARY KEY,
+          callsign    VARCHAR(32)  NOT NULL,
+          callsign_id INT UNSIGNED NULL,
+          tg          INT          NOT NULL,
+          server      VARCHAR(8)   NOT NULL,
+          start_time  DATETIME     NULL,      -- NULL: kein start gefunden
+          end_time    DATETIME     NOT NULL,  -- Zeitpunkt des stop-Events
+          duration_s  INT UNSIGNED NULL,
+          INDEX idx_end_time    (end_time),
+          INDEX idx_tg_end      (tg, end_time),
+          INDEX idx_callsign_end (callsign, end_time)
+        ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+    )SQL";
+
+    if (mysql_query(conn_, q1c) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] create fmqso failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    // fmparser_state: Stand einmaliger Migrationen (z.B. qso_backfill = running/done)
+    static const char* q1d =
+        "CREATE TABLE IF NOT EXISTS fmparser_state ("
+        "  name  VARCHAR(32) NOT NULL PRIMARY KEY,"
+        "  value VARCHAR(32) NOT NULL"
+        ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;";
+
+    if (mysql_query(conn_, q1d) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] create fmparser_state failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
     // fmstatus: nur aktive Stationen (start -> eintragen, stop/Timeout -> löschen)
     static const char* q2 =
         "CREATE TABLE IF NOT EXISTS fmstatus ("
@@ -189,6 +490,8 @@ bool FMDatabase::ensureSchema() noexcept
         CREATE TABLE IF NOT EXISTS fmstats (
           id BIGINT UNSIGNED NOT NULL AUTO_INCREMENT PRIMARY KEY,
           metric        VARCHAR(32) NOT NULL,   -- z.B. 'top_calls_qso', 'heatmap_week'
+          `window`      VARCHAR(8)  NOT NULL DEFAULT '30d',   -- '24h', '7d', '30d', '365d'
+          scope         VARCHAR(16) NOT NULL DEFAULT 'all',   -- 'all', 'tg' (Liste der TG in tg), 'monitored'
           rank          TINYINT UNSIGNED NULL,  -- 1..10 für Top-Listen, sonst NULL
           callsign      VARCHAR(32) NULL,
           tg            INT NULL,
@@ -203,7 +506,9 @@ bool FMDatabase::ensureSchema() noexcept
                         ON UPDATE CURRENT_TIMESTAMP,
           INDEX idx_metric (metric),
           INDEX idx_metric_rank (metric, rank),
-          INDEX idx_metric_wh (metric, weekday, hour)
+          INDEX idx_metric_wh (metric, weekday, hour),
+          INDEX idx_metric_window_rank (metric, `window`, rank),
+          INDEX idx_metric_window_scope (metric, `window`, scope, tg, rank)
         ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
     )SQL";
 
@@ -213,6 +518,23 @@ bool FMDatabase::ensureSchema() noexcept
         return false;
     }
 
+    // ältere Installationen: Spalten nachrüsten (bisherige Listen = 30 Tage, global)
+    static const char* q5a =
+        "ALTER TABLE fmstats "
+        "  ADD COLUMN IF NOT EXISTS `window` VARCHAR(8) NOT NULL DEFAULT '30d' AFTER metric,"
+        "  ADD INDEX IF NOT EXISTS idx_metric_window_rank (metric, `window`, rank)";
+
+    static const char* q5b =
+        "ALTER TABLE fmstats "
+        "  ADD COLUMN IF NOT EXISTS scope VARCHAR(16) NOT NULL DEFAULT 'all' AFTER `window`,"
+        "  ADD INDEX IF NOT EXISTS idx_metric_window_scope (metric, `window`, scope, tg, rank)";
+
+    if (mysql_query(conn_, q5a) != 0 || mysql_query(conn_, q5b) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] alter fmstats failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
     return true;
 }
 
@@ -221,13 +543,18 @@ bool FMDatabase::ensureConn() noexcept
     std::lock_guard<std::mutex> lock(mtx_);
 
     if (!conn_) {
-        return connect();
+        return connectLocked();
     }
 
     if (mysql_ping(conn_) == 0) return true;
 
     std::fprintf(stderr, "[FMDB] ping failed: %s -> reconnect\n", mysql_error(conn_));
-    return connect();
+    return connectLocked();
+}
+
+bool FMDatabase::available() noexcept
+{
+    return ensureConn();
 }
 
 std::string FMDatabase::escape(const std::string& in) noexcept
@@ -244,6 +571,173 @@ std::string FMDatabase::escape(const std::string& in) noexcept
     return out;
 }
 
+template <typename Fn>
+bool FMDatabase::streamQuery(const char* what, const char* sql, Fn&& onRow,
+                             std::uint64_t& rows) noexcept
+{
+    return streamQueryOn(conn_, what, sql, std::forward<Fn>(onRow), rows, lastError_);
+}
+
+template <typename Fn>
+bool FMDatabase::streamQueryOn(MYSQL* c, const char* what, const char* sql, Fn&& onRow,
+                               std::uint64_t& rows, std::string& err) noexcept
+{
+    rows = 0;
+
+    if (mysql_query(c, sql) != 0) {
+        err = mysql_error(c);
+        std::fprintf(stderr, "[FMDB] %s query failed: %s\n", what, err.c_str());
+        return false;
+    }
+
+    MYSQL_RES* res = mysql_use_result(c);
+    if (!res) {
+        err = mysql_error(c);
+        std::fprintf(stderr, "[FMDB] %s use_result failed: %s\n", what, err.c_str());
+        return false;
+    }
+
+    MYSQL_ROW row;
+    bool stopped = false;
+    while ((row = mysql_fetch_row(res)) != nullptr) {
+        ++rows;
+        if constexpr (std::is_same_v<decltype(onRow(row)), bool>) {
+            if (!onRow(row)) {
+                stopped = true;
+                break;
+            }
+        } else {
+            onRow(row);
+        }
+    }
+
+    // fetch_row liefert auch bei Verbindungsabbruch nullptr
+    bool ok = (mysql_errno(c) == 0) && !stopped;
+    if (stopped) {
+        // den Rest liest mysql_free_result noch von der Leitung
+        err = "cancelled";
+        std::fprintf(stderr, "[FMDB] %s stopped after %llu rows\n", what,
+                     static_cast<unsigned long long>(rows));
+    } else if (!ok) {
+        err = mysql_error(c);
+        std::fprintf(stderr, "[FMDB] %s fetch failed after %llu rows: %s\n", what,
+                     static_cast<unsigned long long>(rows), err.c_str());
+    }
+
+    mysql_free_result(res);
+    return ok;
+}
+
+long FMDatabase::peakRssKb() noexcept
+{
+    struct rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return ru.ru_maxrss;   // Linux: kB
+}
+
+void FMDatabase::closeStatements() noexcept
+{
+    for (auto& st : stmts_) {
+        if (st) {
+            mysql_stmt_close(st);
+            st = nullptr;
+        }
+    }
+    stmtThreadId_ = 0;
+}
+
+MYSQL_STMT* FMDatabase::stmt(StmtId id) noexcept
+{
+    if (!conn_) return nullptr;
+
+    // Auto-Reconnect (MYSQL_OPT_RECONNECT) liefert eine neue Server-Session,
+    // in der unsere Statements nicht mehr existieren -> alle neu vorbereiten
+    unsigned long tid = mysql_thread_id(conn_);
+    if (tid != stmtThreadId_) {
+        closeStatements();
+        stmtThreadId_ = tid;
+    }
+
+    if (stmts_[id]) return stmts_[id];
+
+    std::string sql;
+    switch (id) {
+    case StmtInsertHeard1:  sql = makeHeardInsertSql(1);  break;
+    case StmtInsertHeard4:  sql = makeHeardInsertSql(4);  break;
+    case StmtInsertHeard16: sql = makeHeardInsertSql(16); break;
+    case StmtInsertHeard64: sql = makeHeardInsertSql(64); break;
+    case StmtInsertQso1:    sql = makeQsoInsertSql(1);    break;
+    case StmtInsertQso4:    sql = makeQsoInsertSql(4);    break;
+    case StmtInsertQso16:   sql = makeQsoInsertSql(16);   break;
+    case StmtInsertQso64:   sql = makeQsoInsertSql(64);   break;
+    case StmtLastTalk:
+        sql = "SELECT talk FROM fmlastheard WHERE callsign=? ORDER BY id DESC LIMIT 1";
+        break;
+    case StmtNodeReplace:
+        sql = "REPLACE INTO nodes (callsign, location, locator, lat, lon, rx_freq, tx_freq) "
+              "VALUES (?,?,?,?,?,?,?)";
+        break;
+    case StmtCount:
+        return nullptr;
+    }
+
+    MYSQL_STMT* st = mysql_stmt_init(conn_);
+    if (!st) {
+        lastError_ = "mysql_stmt_init failed";
+        return nullptr;
+    }
+
+    if (mysql_stmt_prepare(st, sql.c_str(), static_cast<unsigned long>(sql.size())) != 0) {
+        lastError_ = mysql_stmt_error(st);
+        std::fprintf(stderr, "[FMDB] prepare failed: %s\n", lastError_.c_str());
+        mysql_stmt_close(st);
+        return nullptr;
+    }
+
+    stmts_[id] = st;
+    return st;
+}
+
+bool FMDatabase::execStmt(StmtId id, MYSQL_BIND* params) noexcept
+{
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        MYSQL_STMT* st = stmt(id);
+        if (!st) return false;
+
+        if (params && mysql_stmt_bind_param(st, params)) {
+            lastError_ = mysql_stmt_error(st);
+            return false;
+        }
+
+        if (mysql_stmt_execute(st) == 0) {
+            return true;
+        }
+
+        lastError_ = mysql_stmt_error(st);
+        unsigned int err = mysql_stmt_errno(st);
+
+        // Statement auf dem Server unbekannt: neu vorbereiten, gleiche Session.
+        // Verbindung weg: neu verbinden und wiederholen nur außerhalb einer
+        // Transaktion -- die neue Session hätte die bisherigen Zeilen verloren
+        // und liefe in Autocommit; dort scheitert der Aufruf, der Aufrufer
+        // macht ROLLBACK und schickt den ganzen Batch erneut (Spool)
+        const bool reprepare = (err == ER_UNKNOWN_STMT_HANDLER || err == ER_NEED_REPREPARE);
+        const bool lost      = (err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST);
+        if (attempt > 0 || !(reprepare || (lost && !inTxn_))) {
+            return false;
+        }
+
+        std::fprintf(stderr, "[FMDB] statement failed (%s) -> re-prepare\n", lastError_.c_str());
+        closeStatements();
+        if (lost && mysql_ping(conn_) != 0) {
+            lastError_ = mysql_error(conn_);
+            return false;
+        }
+    }
+
+    return false;
+}
+
 // timeStr: "HH:MM:SS" oder "YYYY-MM-DD HH:MM:SS"
 std::string FMDatabase::makeDateTime(const std::string& timeStr) noexcept
 {
@@ -251,186 +745,880 @@ std::string FMDatabase::makeDateTime(const std::string& timeStr) noexcept
         return timeStr;  // schon ein volles Datum
     }
 
-    std::time_t t = std::time(nullptr);
-    std::tm tm{};
-    localtime_r(&t, &tm);
+    // "YYYY-MM-DD " wird pro Sekunde nur einmal gebaut
+    std::string_view prefix = FmTime::todayPrefix();
 
+    std::string out;
+    out.reserve(prefix.size() + timeStr.size());
+    out.append(prefix.data(), prefix.size());
+    out += timeStr;
+    return out;
+}
+
+bool FMDatabase::deleteExpiredChunk(unsigned days,
+                                    std::size_t maxRows,
+                                    std::uint64_t& deleted) noexcept
+{
+    deleted = 0;
+
+    if (!ensureConn()) {
+        std::fprintf(stderr, "[FMDB] deleteExpiredChunk: no connection: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // LIMIT hält Laufzeit und Row-Locks pro Durchgang klein (Range über idx_event_time)
     std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d") << " " << timeStr;
-    return oss.str();
+    oss << "DELETE FROM fmlastheard "
+           "WHERE event_time < (NOW() - INTERVAL " << days << " DAY) "
+           "LIMIT " << maxRows;
+
+    if (mysql_query(conn_, oss.str().c_str()) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] deleteExpiredChunk failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    deleted = static_cast<std::uint64_t>(mysql_affected_rows(conn_));
+    if (deleted >= maxRows) {
+        return true;
+    }
+
+    // Rest der Portion für fmqso (gleiche Frist, Range über idx_end_time)
+    std::ostringstream oss2;
+    oss2 << "DELETE FROM fmqso "
+            "WHERE end_time < (NOW() - INTERVAL " << days << " DAY) "
+            "LIMIT " << (maxRows - deleted);
+
+    if (mysql_query(conn_, oss2.str().c_str()) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] deleteExpiredChunk (fmqso) failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    deleted += static_cast<std::uint64_t>(mysql_affected_rows(conn_));
+    return true;
+}
+
+bool FMDatabase::clearStatus() noexcept
+{
+    if (!ensureConn()) {
+        std::fprintf(stderr, "[FMDB] clearStatus: no connection: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (mysql_query(conn_, "DELETE FROM fmstatus") != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] clearStatus failed: %s\n", lastError_.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool FMDatabase::globalStatus(const char* name, std::uint64_t& value) noexcept
+{
+    value = 0;
+
+    if (!ensureConn()) {
+        std::fprintf(stderr, "[FMDB] globalStatus: no connection: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    std::string q = "SHOW GLOBAL STATUS LIKE '";
+    q += escape(name);
+    q += "'";
+
+    if (mysql_query(conn_, q.c_str()) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] globalStatus failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    MYSQL_RES* res = mysql_store_result(conn_);
+    if (!res) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] globalStatus: store_result failed: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    bool ok = false;
+    MYSQL_ROW row = mysql_fetch_row(res);
+    if (row && row[1]) {
+        value = std::strtoull(row[1], nullptr, 10);
+        ok = true;
+    }
+    mysql_free_result(res);
+
+    if (!ok) lastError_ = std::string("unknown status variable ") + name;
+    return ok;
+}
+
+// fmstatus = Spiegel von ActiveTalkers: neue/geänderte per REPLACE, entfernte per DELETE
+bool FMDatabase::syncStatus(const std::vector<ActiveTalker>& upserts,
+                            const std::vector<std::string>&  removals) noexcept
+{
+    if (upserts.empty() && removals.empty()) return true;
+
+    if (!ensureConn()) {
+        std::fprintf(stderr, "[FMDB] syncStatus: no connection: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (!removals.empty()) {
+        std::ostringstream oss;
+        oss << "DELETE FROM fmstatus WHERE callsign IN (";
+        for (std::size_t i = 0; i < removals.size(); ++i) {
+            if (i) oss << ",";
+            oss << "'" << escape(removals[i]) << "'";
+        }
+        oss << ")";
+
+        if (mysql_query(conn_, oss.str().c_str()) != 0) {
+            lastError_ = mysql_error(conn_);
+            std::fprintf(stderr, "[FMDB] syncStatus DELETE failed: %s\n", lastError_.c_str());
+            return false;
+        }
+    }
+
+    if (!upserts.empty()) {
+        // callsign ist PRIMARY KEY, also immer max. 1 Zeile pro Callsign
+        std::ostringstream oss;
+        oss << "REPLACE INTO fmstatus (callsign, event_time, tg, server) VALUES ";
+        for (std::size_t i = 0; i < upserts.size(); ++i) {
+            const auto& t = upserts[i];
+            if (i) oss << ",";
+            oss << "("
+                << "'" << escape(t.callsign)  << "',"
+                << "'" << escape(t.eventTime) << "',"
+                <<      t.tg                  << ","
+                << "'" << escape(t.server)    << "')";
+        }
+
+        if (mysql_query(conn_, oss.str().c_str()) != 0) {
+            lastError_ = mysql_error(conn_);
+            std::fprintf(stderr, "[FMDB] syncStatus REPLACE failed: %s\n", lastError_.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FMDatabase::insertEvent(const std::string& timeStr,
+                             const std::string& talk,
+                             const std::string& call,
+                             const std::string& tg,
+                             const std::string& server) noexcept
+{
+    FMEvent ev;
+    ev.kind   = FMEvent::Kind::Talk;
+    ev.time   = timeStr;
+    ev.talk   = talk;
+    ev.call   = call;
+    ev.tg     = tg;
+    ev.server = server;
+
+    return insertEvents(std::vector<FMEvent>{std::move(ev)});
+}
+
+bool FMDatabase::queryLastTalk(const std::string& call, std::string& lastTalk) noexcept
+{
+    lastTalk.clear();
+
+    MYSQL_BIND param[1];
+    unsigned long callLen;
+    bindString(param[0], call, callLen);
+
+    if (!execStmt(StmtLastTalk, param)) {
+        return false;
+    }
+
+    MYSQL_STMT* st = stmts_[StmtLastTalk];
+
+    char          buf[16];
+    unsigned long len = 0;
+    MYSQL_BIND    res[1];
+    std::memset(res, 0, sizeof(res));
+    res[0].buffer_type   = MYSQL_TYPE_STRING;
+    res[0].buffer        = buf;
+    res[0].buffer_length = sizeof(buf);
+    res[0].length        = &len;
+
+    if (mysql_stmt_bind_result(st, res)) {
+        lastError_ = mysql_stmt_error(st);
+        mysql_stmt_free_result(st);
+        return false;
+    }
+
+    int rc = mysql_stmt_fetch(st);
+    if (rc == 0 || rc == MYSQL_DATA_TRUNCATED) {
+        lastTalk.assign(buf, std::min<unsigned long>(len, sizeof(buf)));
+    }
+
+    // restliche Zeilen verwerfen, damit die Verbindung wieder frei ist
+    while (rc == 0 || rc == MYSQL_DATA_TRUNCATED) {
+        rc = mysql_stmt_fetch(st);
+    }
+    mysql_stmt_free_result(st);
+
+    return true;
+}
+
+bool FMDatabase::insertHeardRows(const std::vector<HeardRow>& rows) noexcept
+{
+    std::vector<MYSQL_BIND>    binds;
+    std::vector<unsigned long> lens;
+
+    std::size_t pos = 0;
+    while (pos < rows.size()) {
+        std::size_t left = rows.size() - pos;
+
+        // größten passenden Block nehmen
+        std::size_t n  = 1;
+        StmtId      id = StmtInsertHeard1;
+        if      (left >= kHeardChunks[0]) { n = kHeardChunks[0]; id = StmtInsertHeard64; }
+        else if (left >= kHeardChunks[1]) { n = kHeardChunks[1]; id = StmtInsertHeard16; }
+        else if (left >= kHeardChunks[2]) { n = kHeardChunks[2]; id = StmtInsertHeard4;  }
+
+        binds.assign(n * 6, MYSQL_BIND{});
+        lens.assign(n * 4, 0);
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const HeardRow& r = rows[pos + i];
+            bindString(binds[i * 6 + 0], r.dt,     lens[i * 4 + 0]);
+            bindString(binds[i * 6 + 1], r.talk,   lens[i * 4 + 1]);
+            bindString(binds[i * 6 + 2], r.call,   lens[i * 4 + 2]);
+            bindUInt64(binds[i * 6 + 3], r.callId);
+            bindInt   (binds[i * 6 + 4], r.tg);
+            bindString(binds[i * 6 + 5], r.server, lens[i * 4 + 3]);
+        }
+
+        if (!execStmt(id, binds.data())) {
+            std::fprintf(stderr, "[FMDB] INSERT fmlastheard (%zu rows) failed: %s\n",
+                         n, lastError_.c_str());
+            return false;
+        }
+
+        pos += n;
+    }
+
+    return true;
+}
+
+bool FMDatabase::insertQsoRows(const std::vector<QsoRow>& rows) noexcept
+{
+    std::vector<MYSQL_BIND>    binds;
+    std::vector<unsigned long> lens;
+
+    std::size_t pos = 0;
+    while (pos < rows.size()) {
+        std::size_t left = rows.size() - pos;
+
+        // größten passenden Block nehmen (wie bei fmlastheard)
+        std::size_t n  = 1;
+        StmtId      id = StmtInsertQso1;
+        if      (left >= kHeardChunks[0]) { n = kHeardChunks[0]; id = StmtInsertQso64; }
+        else if (left >= kHeardChunks[1]) { n = kHeardChunks[1]; id = StmtInsertQso16; }
+        else if (left >= kHeardChunks[2]) { n = kHeardChunks[2]; id = StmtInsertQso4;  }
+
+        binds.assign(n * 7, MYSQL_BIND{});
+        lens.assign(n * 4, 0);
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const QsoRow& r = rows[pos + i];
+            bindString(binds[i * 7 + 0], r.call,   lens[i * 4 + 0]);
+            bindUInt64(binds[i * 7 + 1], r.callId);
+            bindInt   (binds[i * 7 + 2], r.tg);
+            bindString(binds[i * 7 + 3], r.server, lens[i * 4 + 1]);
+            if (!r.startDt.empty()) bindString(binds[i * 7 + 4], r.startDt, lens[i * 4 + 2]);
+            else                    bindNull  (binds[i * 7 + 4]);
+            bindString(binds[i * 7 + 5], r.endDt,  lens[i * 4 + 3]);
+            if (r.hasDuration) bindUInt64(binds[i * 7 + 6], r.durationSec);
+            else               bindNull  (binds[i * 7 + 6]);
+        }
+
+        if (!execStmt(id, binds.data())) {
+            std::fprintf(stderr, "[FMDB] INSERT fmqso (%zu rows) failed: %s\n",
+                         n, lastError_.c_str());
+            return false;
+        }
+
+        pos += n;
+    }
+
+    return true;
+}
+
+std::string FMDatabase::qsoKey(const std::string& call, int tg, const std::string& server)
+{
+    std::string k;
+    k.reserve(call.size() + server.size() + 14);
+    k += call;
+    k += '\x1f';
+    k += std::to_string(tg);
+    k += '\x1f';
+    k += server;
+    return k;
+}
+
+bool FMDatabase::insertEvents(const std::vector<FMEvent>& events,
+                              std::vector<LastHeardQso>* committed) noexcept
+{
+    if (events.empty()) return true;
+
+    if (!ensureConn()) {
+        std::fprintf(stderr, "[FMDB] insertEvents: no connection: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // kein stilles Auto-Reconnect mitten in der Transaktion (sonst liefen die
+    // restlichen Zeilen in einer neuen Session ohne die bisherigen)
+    if (!beginTxn()) {
+        return false;
+    }
+
+    std::vector<HeardRow> rows;
+    rows.reserve(events.size());
+
+    // start/stop-Paare für fmqso; openQsos_ wird erst nach dem COMMIT angepasst,
+    // bis dahin gelten die Änderungen dieses Batches (leer = geschlossen)
+    std::vector<QsoRow> qsos;
+    std::unordered_map<std::string, std::string> batchOpen;
+
+    for (const auto& ev : events) {
+        std::string dt = makeDateTime(ev.time);
+
+        int tgInt = 0;
+        try {
+            tgInt = std::stoi(ev.tg);
+        } catch (...) {
+            tgInt = 0;
+        }
+
+        //
+        // doppelte "stop"-Events für ein Callsign verhindern
+        //
+        if (ev.talk == "stop") {
+            bool lastIsStop = false;
+
+            if (auto it = lastTalkIsStop_.find(ev.call); it != lastTalkIsStop_.end()) {
+                lastIsStop = it->second;
+            } else {
+                // Cache-Miss -> DB fragen und Ergebnis merken
+                std::string lastTalk;
+                if (!queryLastTalk(ev.call, lastTalk)) {
+                    std::fprintf(stderr, "[FMDB] insertEvents: query last talk failed: %s\n",
+                                 lastError_.c_str());
+                    // im Zweifel lieber trotzdem weitermachen und den Stop loggen
+                } else {
+                    lastIsStop = (lastTalk == "stop");
+                    lastTalkIsStop_[ev.call] = lastIsStop;
+                }
+            }
+
+            if (lastIsStop) {
+                // Zweiter stop hintereinander -> ignorieren
+                continue;
+            }
+        }
+
+        //
+        // Zeile für den Multi-Row-INSERT sammeln
+        //
+        if (ev.call.rfind("TG", 0) == std::string::npos) {
+            // beginnt NICHT mit "TG"
+            // verhindert dass die lästigen TG2328 die Liste verstopfen
+            const std::uint32_t callId = CallsignDict::intern(ev.call);
+
+            if (ev.talk == "start") {
+                batchOpen[qsoKey(ev.call, tgInt, ev.server)] = dt;
+            } else if (ev.talk == "stop") {
+                std::string key = qsoKey(ev.call, tgInt, ev.server);
+
+                QsoRow q;
+                q.call   = ev.call;
+                q.callId = callId;
+                q.tg     = tgInt;
+                q.server = ev.server;
+                q.endDt  = dt;
+                if (auto it = batchOpen.find(key); it != batchOpen.end()) {
+                    q.startDt = it->second;
+                } else if (auto it2 = openQsos_.find(key); it2 != openQsos_.end()) {
+                    q.startDt = it2->second;
+                }
+
+                // wie TIMESTAMPDIFF: nur ein start vor dem stop zählt
+                std::time_t ts{}, te{};
+                if (!q.startDt.empty() && q.startDt <= q.endDt &&
+                    FmTime::parseDateTime(q.startDt, ts) && FmTime::parseDateTime(q.endDt, te) &&
+                    te >= ts) {
+                    q.durationSec = static_cast<std::uint64_t>(te - ts);
+                    q.hasDuration = true;
+                } else {
+                    q.startDt.clear();
+                }
+
+                batchOpen[key].clear();
+                qsos.push_back(std::move(q));
+            }
+
+            rows.push_back(HeardRow{std::move(dt), ev.talk, ev.call,
+                                    callId, tgInt, ev.server});
+            lastTalkIsStop_[ev.call] = (ev.talk == "stop");
+        }
+    }
+
+    // bei Fehlern stimmt der Cache für die Callsigns dieses Batches nicht mehr
+    auto forgetBatch = [&]() {
+        for (const auto& r : rows) {
+            lastTalkIsStop_.erase(r.call);
+        }
+        endTxn(false);
+    };
+
+    // neue Callsigns in derselben Transaktion -> keine ID ohne Namen in der DB
+    const std::uint32_t dictSize = CallsignDict::size();
+
+    if (!insertCallsigns(CallsignDict::persisted(), dictSize) || !insertHeardRows(rows) ||
+        !insertQsoRows(qsos)) {
+        forgetBatch();
+        return false;
+    }
+
+    if (!endTxn(true)) {
+        forgetBatch();
+        return false;
+    }
+
+    CallsignDict::markPersisted(dictSize);
+
+    if (committed) {
+        for (auto& q : qsos) {
+            committed->push_back(LastHeardQso{std::move(q.call), q.tg, std::move(q.server),
+                                              std::move(q.endDt), q.durationSec, q.hasDuration});
+        }
+    }
+
+    for (auto& kv : batchOpen) {
+        if (kv.second.empty()) {
+            openQsos_.erase(kv.first);
+        } else {
+            openQsos_[kv.first] = std::move(kv.second);
+        }
+    }
+    return true;
+}
+
+bool FMDatabase::beginTxn() noexcept
+{
+    bool off = false;
+    mysql_options(conn_, MYSQL_OPT_RECONNECT, &off);
+
+    if (mysql_query(conn_, "START TRANSACTION") != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] START TRANSACTION failed: %s\n", lastError_.c_str());
+        bool on = true;
+        mysql_options(conn_, MYSQL_OPT_RECONNECT, &on);
+        return false;
+    }
+
+    inTxn_     = true;
+    txnThread_ = mysql_thread_id(conn_);
+    return true;
 }
 
-bool FMDatabase::pruneIfNeeded() noexcept
+bool FMDatabase::endTxn(bool commit) noexcept
 {
-    if (!conn_) return false;
+    if (!inTxn_) return false;
+
+    bool ok = true;
+    if (commit) {
+        // andere Session (darf ohne Reconnect nicht sein) -> nichts committet
+        if (mysql_thread_id(conn_) != txnThread_) {
+            lastError_ = "connection changed during transaction";
+            ok = false;
+        } else if (mysql_query(conn_, "COMMIT") != 0) {
+            lastError_ = mysql_error(conn_);
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "[FMDB] COMMIT failed: %s\n", lastError_.c_str());
+        }
+    }
+    if (!commit || !ok) {
+        mysql_query(conn_, "ROLLBACK");   // Verbindung weg -> Server hat schon zurückgerollt
+    }
+
+    inTxn_ = false;
+    bool on = true;
+    mysql_options(conn_, MYSQL_OPT_RECONNECT, &on);
+    return ok;
+}
+
+bool FMDatabase::insertCallsigns(std::uint32_t from, std::uint32_t to) noexcept
+{
+    std::vector<std::uint32_t> ids;
+    for (std::uint32_t id = from; id < to; ++id) {
+        ids.push_back(id);
+    }
+    // kein IGNORE: ein Konflikt heißt, Tabelle und CallsignDict passen nicht
+    // zusammen -> Transaktion scheitert, statt einen Namen still zu verlieren
+    return writeCallsigns(ids, "INSERT INTO callsigns (id, callsign, country_code) VALUES ",
+                          "");
+}
+
+bool FMDatabase::writeCallsigns(const std::vector<std::uint32_t>& ids, const char* head,
+                                const char* tail) noexcept
+{
+    // Portionen, damit die Nachrüstung großer Tabellen unter max_allowed_packet bleibt
+    constexpr std::size_t kChunk = 1000;
+
+    for (std::size_t i = 0; i < ids.size(); i += kChunk) {
+        std::string q = head;
+        bool any = false;
+
+        for (std::size_t j = i; j < ids.size() && j < i + kChunk; ++j) {
+            std::string_view name = CallsignDict::name(ids[j]);
+            if (name.empty()) continue;   // Lücke aus der Tabelle
+
+            const std::string cc = CallsignDict::country(ids[j]);
+
+            if (any) q += ",";
+            q += "(" + std::to_string(ids[j]) + ",'" + escape(std::string(name)) + "'," +
+                 (cc.empty() ? std::string("NULL") : "'" + escape(cc) + "'") + ")";
+            any = true;
+        }
+        if (!any) continue;
+        q += tail;
+
+        if (mysql_query(conn_, q.c_str()) != 0) {
+            lastError_ = mysql_error(conn_);
+            std::fprintf(stderr, "[FMDB] write callsigns failed: %s\n", lastError_.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FMDatabase::loadCallsigns() noexcept
+{
+    static const char* q = "SELECT id, callsign, country_code FROM callsigns ORDER BY id";
+
+    std::uint64_t rows  = 0;
+    std::uint64_t bad   = 0;
+    std::uint32_t endId = 0;
+    std::vector<std::uint32_t> stale;   // Ländercode in der Tabelle fehlt oder veraltet
+    bool ok = streamQuery("loadCallsigns", q, [&bad, &endId, &stale](MYSQL_ROW row) {
+        if (!row[0] || !row[1]) return;
+        auto id = static_cast<std::uint32_t>(std::strtoul(row[0], nullptr, 10));
+        const std::string_view stored = row[2] ? std::string_view(row[2]) : std::string_view();
+        if (!CallsignDict::restore(id, row[1], stored)) {
+            ++bad;
+            return;
+        }
+        if (CallsignDict::country(id) != stored) stale.push_back(id);
+        endId = std::max(endId, id + 1);
+    }, rows);
+
+    if (!ok) return false;
+
+    CallsignDict::markPersisted(endId);
+    CallsignDict::setLoaded();
 
-    // alles löschen, was älter als 50 Tage ist
+    std::fprintf(stderr, "[FMDB] callsign dictionary: %llu entries (%llu rejected)\n",
+                 static_cast<unsigned long long>(rows), static_cast<unsigned long long>(bad));
+
+    // nach Update der Präfixliste bzw. beim ersten Start mit der Spalte;
+    // Fehler sind nicht fatal, api.php löst fehlende Codes selbst auf
+    if (!stale.empty()) {
+        if (writeCallsigns(stale, "INSERT INTO callsigns (id, callsign, country_code) VALUES ",
+                           " ON DUPLICATE KEY UPDATE country_code = VALUES(country_code)")) {
+            std::fprintf(stderr, "[FMDB] callsign dictionary: %zu country codes updated\n",
+                         stale.size());
+        }
+    }
+    return true;
+}
+
+bool FMDatabase::warmLastTalkCache() noexcept
+{
+    if (!ensureConn()) {
+        std::fprintf(stderr, "[FMDB] warmLastTalkCache: no connection: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // letzte Zeile je Callsign (MAX(id) über idx_callsign)
+    // endet die Zeile mit start, ist das QSO noch offen (fmqso)
     static const char* q =
-        "DELETE FROM fmlastheard "
-        "WHERE event_time < (NOW() - INTERVAL 365 DAY)";
+        "SELECT f.callsign, f.talk, f.event_time, f.tg, f.server "
+        "FROM fmlastheard f "
+        "JOIN (SELECT callsign, MAX(id) AS mid FROM fmlastheard GROUP BY callsign) m "
+        "  ON f.id = m.mid";
+
+    lastTalkIsStop_.clear();
+    openQsos_.clear();
+
+    std::uint64_t rows = 0;
+    bool ok = streamQuery("warmLastTalkCache", q, [this](MYSQL_ROW row) {
+        if (!row[0] || !row[1]) return;
+        bool stop = (std::strcmp(row[1], "stop") == 0);
+        lastTalkIsStop_[row[0]] = stop;
+
+        if (!stop && row[2] && row[3] && row[4]) {
+            openQsos_[qsoKey(row[0], std::atoi(row[3]), row[4])] = row[2];
+        }
+    }, rows);
+
+    if (!ok) {
+        lastTalkIsStop_.clear();
+        openQsos_.clear();
+        return false;
+    }
+
+    std::fprintf(stderr, "[FMDB] last-talk cache: %zu callsigns, %zu open QSOs\n",
+                 lastTalkIsStop_.size(), openQsos_.size());
+    return true;
+}
+
+// erste Spalte der ersten Zeile, "" ohne Zeile; false bei Fehler (Aufrufer hält mtx_)
+bool FMDatabase::queryValue(const char* sql, std::string& out) noexcept
+{
+    out.clear();
+    if (mysql_query(conn_, sql) != 0) {
+        lastError_ = mysql_error(conn_);
+        return false;
+    }
+    MYSQL_RES* res = mysql_store_result(conn_);
+    if (!res) {
+        lastError_ = mysql_error(conn_);
+        return false;
+    }
+    if (MYSQL_ROW row = mysql_fetch_row(res); row && row[0]) {
+        out = row[0];
+    }
+    mysql_free_result(res);
+    return true;
+}
+
+bool FMDatabase::setBackfillState(const char* value) noexcept
+{
+    std::string q = "REPLACE INTO fmparser_state (name, value) VALUES ('qso_backfill','";
+    q += value;
+    q += "')";
+    if (mysql_query(conn_, q.c_str()) != 0) {
+        lastError_ = mysql_error(conn_);
+        std::fprintf(stderr, "[FMDB] backfillQsos: state %s failed: %s\n", value, lastError_.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool FMDatabase::backfillQsos() noexcept
+{
+    if (!ensureConn()) {
+        std::fprintf(stderr, "[FMDB] backfillQsos: no connection: %s\n", lastError_.c_str());
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+
+        std::string state, any;
+        if (!queryValue("SELECT value FROM fmparser_state WHERE name = 'qso_backfill'", state) ||
+            !queryValue("SELECT 1 FROM fmqso LIMIT 1", any)) {
+            std::fprintf(stderr, "[FMDB] backfillQsos: state query failed: %s\n", lastError_.c_str());
+            return false;
+        }
+
+        if (state == "done") return true;
+        if (state.empty() && !any.empty()) {
+            // fmqso aus einer Version vor dem Status (Backfill damals in einem Statement)
+            return setBackfillState("done");
+        }
+
+        // abgebrochener Lauf (state running): fmqso stammt nur daraus bzw. aus Events,
+        // die auch in fmlastheard stehen -> verwerfen und komplett neu paaren
+        if (state == "running" && mysql_query(conn_, "TRUNCATE TABLE fmqso") != 0) {
+            lastError_ = mysql_error(conn_);
+            std::fprintf(stderr, "[FMDB] backfillQsos: truncate failed: %s\n", lastError_.c_str());
+            return false;
+        }
+        if (!setBackfillState("running")) return false;
+    }
+
+    // einmalig dieselbe Paarung wie früher in api.php: letzter start mit gleichem
+    // Callsign/TG/Server bis zum stop. Ein sortierter Scan über eine eigene
+    // Verbindung, gepaart wird hier; geschrieben in Portionen mit eigenem COMMIT.
+    // Sortierung binär, CallsignDict unterscheidet Groß/Klein; bei gleicher Zeit
+    // zählt der start vor dem stop (wie event_time <= stop in der alten Abfrage)
+    static const char* q = R"SQL(
+        SELECT callsign, callsign_id, tg, server,
+               DATE_FORMAT(event_time, '%Y-%m-%d %H:%i:%s'), talk
+        FROM fmlastheard
+        WHERE talk IN ('start', 'stop')
+        ORDER BY CAST(callsign AS BINARY), tg, CAST(server AS BINARY),
+                 event_time, talk, id
+    )SQL";
+
+    constexpr std::size_t kChunk = 5000;
+
+    const auto t0 = std::chrono::steady_clock::now();
 
-    if (mysql_query(conn_, q) != 0) {
-        lastError_ = mysql_error(conn_);
-        std::fprintf(stderr, "[FMDB] pruneIfNeeded (365 days) failed: %s\n",
-                     lastError_.c_str());
+    std::string err;
+    MYSQL* scan = openConnection(err);
+    if (!scan) {
+        lastError_ = err;
         return false;
     }
 
-    return true;
-}
+    std::vector<QsoRow> chunk;
+    chunk.reserve(kChunk);
+    std::uint64_t written = 0;
 
-// fmstatus pflegen: start -> eintragen/aktualisieren, stop -> löschen
-bool FMDatabase::updateStatus(const std::string& dt,
-                              const std::string& talk,
-                              const std::string& call,
-                              int tg,
-                              const std::string& server) noexcept
-{
-    if (!conn_) return false;
+    auto flush = [&]() -> bool {
+        if (chunk.empty()) return true;
 
-    // nur start/stop relevant
-    if (talk == "start") {
-        std::string callE = escape(call);
-        std::string srvE  = escape(server);
-        std::string dtE   = escape(dt);
+        std::lock_guard<std::mutex> lock(mtx_);
 
-        // REPLACE INTO -> callsign ist PRIMARY KEY, also immer max. 1 Zeile pro Callsign
-        std::ostringstream oss;
-        oss << "REPLACE INTO fmstatus (callsign, event_time, tg, server) VALUES ("
-            << "'" << callE << "',"
-            << "'" << dtE   << "',"
-            <<      tg      << ","
-            << "'" << srvE  << "')";
-        if (mysql_query(conn_, oss.str().c_str()) != 0) {
-            lastError_ = mysql_error(conn_);
-            std::fprintf(stderr, "[FMDB] updateStatus REPLACE failed: %s\n", lastError_.c_str());
-            return false;
-        }
-    } else if (talk == "stop") {
-        std::string callE = escape(call);
-        std::string q = "DELETE FROM fmstatus WHERE callsign='" + callE + "'";
-        if (mysql_query(conn_, q.c_str()) != 0) {
-            lastError_ = mysql_error(conn_);
-            std::fprintf(stderr, "[FMDB] updateStatus DELETE failed: %s\n", lastError_.c_str());
+        // neue IDs (alte Zeilen ohne callsign_id) in derselben Transaktion
+        const std::uint32_t dictSize = CallsignDict::size();
+        if (!beginTxn()) return false;
+        if (!insertCallsigns(CallsignDict::persisted(), dictSize) || !insertQsoRows(chunk)) {
+            endTxn(false);
             return false;
         }
-    }
+        if (!endTxn(true)) return false;
 
-    return true;
-}
+        CallsignDict::markPersisted(dictSize);
+        written += chunk.size();
+        chunk.clear();
+        return true;
+    };
 
-// alles löschen, was seit > 3 Minuten nicht aktualisiert wurde
-bool FMDatabase::cleanupStatus() noexcept
-{
-    if (!conn_) return false;
+    std::string curCall, curServer, lastStart;
+    int         curTg = 0;
+    bool        writeFailed = false;
 
-    static const char* q =
-        "DELETE FROM fmstatus "
-        "WHERE last_update < (NOW() - INTERVAL 3 MINUTE)";
+    std::uint64_t rows = 0;
+    bool ok = streamQueryOn(scan, "backfillQsos", q, [&](MYSQL_ROW row) {
+        if (!row[0] || !row[2] || !row[3] || !row[4] || !row[5]) return true;
 
-    if (mysql_query(conn_, q) != 0) {
-        lastError_ = mysql_error(conn_);
-        std::fprintf(stderr, "[FMDB] cleanupStatus failed: %s\n", lastError_.c_str());
+        const int tg = std::atoi(row[2]);
+        if (curCall != row[0] || curTg != tg || curServer != row[3]) {
+            curCall   = row[0];
+            curTg     = tg;
+            curServer = row[3];
+            lastStart.clear();
+        }
+
+        if (std::strcmp(row[5], "start") == 0) {
+            lastStart = row[4];
+            return true;
+        }
+
+        QsoRow r;
+        r.call    = curCall;
+        r.callId  = row[1] ? std::strtoull(row[1], nullptr, 10) : CallsignDict::intern(curCall);
+        r.tg      = tg;
+        r.server  = curServer;
+        r.startDt = lastStart;
+        r.endDt   = row[4];
+
+        std::time_t ts{}, te{};
+        if (!r.startDt.empty() && FmTime::parseDateTime(r.startDt, ts) &&
+            FmTime::parseDateTime(r.endDt, te) && te >= ts) {
+            r.durationSec = static_cast<std::uint64_t>(te - ts);
+            r.hasDuration = true;
+        }
+        chunk.push_back(std::move(r));
+
+        if (chunk.size() >= kChunk && !flush()) {
+            writeFailed = true;
+            return false;
+        }
+        return true;
+    }, rows, err);
+    mysql_close(scan);
+
+    if (ok) ok = flush();
+    if (!ok) {
+        if (!writeFailed && !err.empty()) lastError_ = err;
+        std::fprintf(stderr, "[FMDB] backfillQsos failed after %llu QSOs: %s "
+                     "(restarts on next start)\n",
+                     static_cast<unsigned long long>(written), lastError_.c_str());
         return false;
     }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!setBackfillState("done")) return false;
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - t0).count();
+    std::fprintf(stdout, "[FMDB] backfillQsos: %llu QSOs from %llu fmlastheard rows in %lld ms\n",
+                 static_cast<unsigned long long>(written), static_cast<unsigned long long>(rows),
+                 static_cast<long long>(ms));
     return true;
 }
 
-bool FMDatabase::insertEvent(const std::string& timeStr,
-                             const std::string& talk,
-                             const std::string& call,
-                             const std::string& tg,
-                             const std::string& server) noexcept
+bool FMDatabase::loadLastHeard(LastHeard& out) noexcept
 {
+    out.clear();
+
     if (!ensureConn()) {
-        std::fprintf(stderr, "[FMDB] insertEvent: no connection: %s\n", lastError_.c_str());
+        std::fprintf(stderr, "[FMDB] loadLastHeard: no connection: %s\n", lastError_.c_str());
         return false;
     }
 
     std::lock_guard<std::mutex> lock(mtx_);
 
-    std::string dt     = makeDateTime(timeStr);
-    std::string talkE  = escape(talk);
-    std::string callE  = escape(call);
-    std::string srvE   = escape(server);
-
-    int tgInt = 0;
-    try {
-        tgInt = std::stoi(tg);
-    } catch (...) {
-        tgInt = 0;
-    }
-
-    //
-    // doppelte "stop"-Events für ein Callsign verhindern
-    //
-    if (talk == "stop") {
-        std::string qLast =
-            "SELECT talk FROM fmlastheard "
-            "WHERE callsign='" + callE + "' "
-            "ORDER BY id DESC "
-            "LIMIT 1";
-
-        if (mysql_query(conn_, qLast.c_str()) != 0) {
-            lastError_ = mysql_error(conn_);
-            std::fprintf(stderr, "[FMDB] insertEvent: query last talk failed: %s\n",
-                         lastError_.c_str());
-            // im Zweifel lieber trotzdem weitermachen und den Stop loggen
-        } else {
-            MYSQL_RES* res = mysql_store_result(conn_);
-            if (res) {
-                MYSQL_ROW row = mysql_fetch_row(res);
-                if (row && row[0]) {
-                    std::string lastTalk = row[0];
-                    if (lastTalk == "stop") {
-                        // Zweiter stop hintereinander -> ignorieren
-                        mysql_free_result(res);
-                        // fmstatus ist ohnehin schon "nicht aktiv", also updateStatus hier NICHT aufrufen
-                        return true;
-                    }
-                }
-                mysql_free_result(res);
-            }
-        }
-    }
-
-    //
-    // normaler INSERT, wenn wir hier sind
-    //
-    if (callE.rfind("TG", 0) == std::string::npos) {
-        // beginnt NICHT mit "TG"
-        // verhindert dass die lästigen TG2328 die Liste verstopfen
-        std::ostringstream oss;
-        oss << "INSERT INTO fmlastheard (event_time, talk, callsign, tg, server) VALUES ("
-            << "'" << escape(dt)   << "',"
-            << "'" << talkE        << "',"
-            << "'" << callE        << "',"
-            <<      tgInt          << ","
-            << "'" << srvE         << "')";
+    std::uint64_t nodes = 0;
+    bool ok = streamQuery("loadLastHeard nodes",
+                          "SELECT callsign, location FROM nodes WHERE location IS NOT NULL",
+                          [&out](MYSQL_ROW row) {
+                              if (row[0] && row[1]) out.setLocation(row[0], row[1]);
+                          }, nodes);
+    if (!ok) return false;
 
-        if (mysql_query(conn_, oss.str().c_str()) != 0) {
-            lastError_ = mysql_error(conn_);
-            std::fprintf(stderr, "[FMDB] INSERT fmlastheard failed: %s\n", lastError_.c_str());
-            return false;
+    // je TG die neuesten kRows (die globale Liste ist darin enthalten),
+    // aufsteigend, damit LastHeard nur hinten anhängt
+    std::ostringstream oss;
+    oss << "SELECT callsign, tg, server, end_time, duration_s FROM ("
+           "  SELECT id, callsign, tg, server, end_time, duration_s,"
+           "         ROW_NUMBER() OVER (PARTITION BY tg ORDER BY end_time DESC, id DESC) AS rn"
+           "  FROM fmqso"
+           ") x WHERE rn <= " << LastHeard::kRows << " ORDER BY end_time, id";
+
+    std::uint64_t qsos = 0;
+    ok = streamQuery("loadLastHeard fmqso", oss.str().c_str(), [&out](MYSQL_ROW row) {
+        if (!row[0] || !row[1] || !row[2] || !row[3]) return;
+        LastHeardQso q;
+        q.callsign = row[0];
+        q.tg       = std::atoi(row[1]);
+        q.server   = row[2];
+        q.endTime  = row[3];
+        if (row[4]) {
+            q.durationSec = std::strtoull(row[4], nullptr, 10);
+            q.hasDuration = true;
         }
-    }
-
-    // fmstatus für "start"/"stop" pflegen
-    if (!updateStatus(dt, talk, call, tgInt, server)) {
-        std::fprintf(stderr, "[FMDB] updateStatus failed: %s\n", lastError_.c_str());
-        // kein harter Fehler für insertEvent
-    }
-
-    // fmlastheard begrenzen
-    if (!pruneIfNeeded()) {
-        std::fprintf(stderr, "[FMDB] pruneIfNeeded failed: %s\n", lastError_.c_str());
-    }
-
-    // fmstatus Timeout (alles, was > 3min alt ist, entfernen)
-    if (!cleanupStatus()) {
-        std::fprintf(stderr, "[FMDB] cleanupStatus failed: %s\n", lastError_.c_str());
-    }
+        out.add(q);
+    }, qsos);
+    if (!ok) return false;
 
+    std::fprintf(stdout, "[FMDB] loadLastHeard: %llu QSOs, %llu node locations\n",
+                 static_cast<unsigned long long>(qsos), static_cast<unsigned long long>(nodes));
     return true;
 }
 
@@ -449,40 +1637,18 @@ bool FMDatabase::upsertNode(const std::string& callsign,
 
     std::lock_guard<std::mutex> lock(mtx_);
 
-    std::string callE     = escape(callsign);
-    std::string locE      = escape(location);
-    std::string locatorE  = escape(locator);
-    std::string rxE       = escape(rx_freq);
-    std::string txE       = escape(tx_freq);
-
     // lat/lon -> NULL falls NaN (z.B. wenn nicht gesetzt)
-    bool latValid = !std::isnan(lat);
-    bool lonValid = !std::isnan(lon);
-
-    std::ostringstream oss;
-    oss << "REPLACE INTO nodes (callsign, location, locator, lat, lon, rx_freq, tx_freq) VALUES ("
-        << "'" << callE   << "',"
-        << "'" << locE    << "',"
-        << "'" << locatorE<< "',";
-
-    if (latValid)
-        oss << lat;
-    else
-        oss << "NULL";
-
-    oss << ",";
-
-    if (lonValid)
-        oss << lon;
-    else
-        oss << "NULL";
-
-    oss << ","
-        << "'" << rxE << "',"
-        << "'" << txE << "')";
-    
-    if (mysql_query(conn_, oss.str().c_str()) != 0) {
-        lastError_ = mysql_error(conn_);
+    MYSQL_BIND b[7];
+    unsigned long len[5];
+    bindString(b[0], callsign, len[0]);
+    bindString(b[1], location, len[1]);
+    bindString(b[2], locator,  len[2]);
+    if (!std::isnan(lat)) bindDouble(b[3], lat); else bindNull(b[3]);
+    if (!std::isnan(lon)) bindDouble(b[4], lon); else bindNull(b[4]);
+    bindString(b[5], rx_freq,  len[3]);
+    bindString(b[6], tx_freq,  len[4]);
+
+    if (!execStmt(StmtNodeReplace, b)) {
         std::fprintf(stderr, "[FMDB] upsertNode REPLACE failed: %s\n", lastError_.c_str());
         return false;
     }
@@ -640,225 +1806,251 @@ bool FMDatabase::getConfig(ConfigRow& out) noexcept
 }
 
 // ---------------- Statistik ----------------
-bool FMDatabase::parseDateTimeToTimeT(const char* s, std::time_t& out) noexcept
+bool FMDatabase::scanQsoAggregates(QsoAggregator& out, std::uint64_t* rows,
+                                   unsigned threads) noexcept
 {
-    if (!s) return false;
+    out.clear();
+    if (threads == 0) threads = ParserSettings::statsThreads;
+
+    // Fenster wie im QsoAggregator: ab lokaler Mitternacht vor 364 Tagen
+    char cutoff[11];
+    FmTime::formatDay(FmTime::localDay(std::time(nullptr)) - (QsoAggregator::kHistoryDays - 1), cutoff);
+
+    const auto    t0        = std::chrono::steady_clock::now();
+    const long    rssBefore = peakRssKb();
+    std::uint64_t n = 0;
+    bool          ok;
+
+    if (threads > 1) {
+        ok = scanQsoAggregatesSharded(out, cutoff, threads, n);
+    } else {
+        if (!ensureConn()) {
+            std::fprintf(stderr, "[FMDB] scanQsoAggregates: no connection: %s\n",
+                         lastError_.c_str());
+            return false;
+        }
 
-    std::tm tm{};
-    tm.tm_isdst = -1;
+        std::lock_guard<std::mutex> lock(mtx_);
 
-    std::istringstream iss(s);
-    iss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-    if (iss.fail()) {
-        return false;
+        // ungepuffert: nur die aktuelle Zeile liegt im Client-Speicher
+        ok = streamQuery("scanQsoAggregates", makeScanSql(cutoff, 1, 0).c_str(),
+                         [this, &out](MYSQL_ROW row) {
+                             if (cancelled()) return false;
+                             scanRow(out, row);
+                             return true;
+                         }, n);
     }
 
-    std::time_t t = std::mktime(&tm);
-    if (t == static_cast<std::time_t>(-1)) {
+    if (rows) *rows = n;
+    if (!ok) {
+        out.clear();
         return false;
     }
 
-    out = t;
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - t0).count();
+    std::fprintf(stdout, "[FMDB] scanQsoAggregates: %llu rows in %lld ms (%u thread%s), "
+                 "peak RSS %ld kB (before %ld kB)\n",
+                 static_cast<unsigned long long>(n), static_cast<long long>(ms),
+                 threads > 1 ? threads : 1u, threads > 1 ? "s" : "",
+                 peakRssKb(), rssBefore);
     return true;
 }
 
-bool FMDatabase::computeQsoAggregatesLast30Days(CallAggMap&   perCall,
-                                                TgAggMap&     perTg,
-                                                TgCountMap&   perTgCount,
-                                                FMQsoHeatmap& heatmapWeek) noexcept
+// Die start/stop-Paarung hängt nur am Callsign -> Callsigns per CRC32 auf
+// threads Shards verteilen, jeder Shard eine eigene Verbindung, ein eigener
+// Thread und ein eigener QsoAggregator, am Ende zusammengeführt.
+// Ein Shard je Thread: jede Shard-Abfrage liest den ganzen Zeitraum über
+// idx_event_time, mehr Shards hieße mehr Arbeit für den Server.
+bool FMDatabase::scanQsoAggregatesSharded(QsoAggregator& out, const char* cutoff,
+                                          unsigned threads, std::uint64_t& rows) noexcept
 {
-    perCall.clear();
-    perTg.clear();
-    perTgCount.clear();
+    std::vector<QsoAggregator> parts(threads);
+    std::vector<std::string>   errors(threads);
+    std::vector<std::uint64_t> counts(threads, 0);
+    std::atomic<bool>          failed{false};
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned k = 0; k < threads; ++k) {
+        try {
+            workers.emplace_back([this, k, threads, cutoff, &parts, &errors, &counts, &failed] {
+                const std::atomic<bool>* cancel = cancel_;
+                mysql_thread_init();
+
+                MYSQL* c = openConnection(errors[k]);
+                if (c) {
+                    QsoAggregator& part = parts[k];
+                    bool ok = streamQueryOn(c, "scanQsoAggregates shard",
+                                            makeScanSql(cutoff, threads, k).c_str(),
+                                            [&part, cancel, &failed](MYSQL_ROW row) {
+                                                if (failed || (cancel && *cancel)) return false;
+                                                scanRow(part, row);
+                                                return true;
+                                            },
+                                            counts[k], errors[k]);
+                    if (!ok) failed = true;
+                    mysql_close(c);
+                } else {
+                    failed = true;
+                }
 
-    // Heatmap initialisieren
-    for (auto& day : heatmapWeek) {
-        day.fill(0);
+                mysql_thread_end();
+            });
+        } catch (const std::system_error& e) {
+            errors[k] = e.what();
+            failed = true;
+            break;
+        }
     }
-
-    if (!ensureConn()) {
-        std::fprintf(stderr, "[FMDB] computeQsoAggregatesLast30Days: no connection: %s\n",
-                     lastError_.c_str());
-        return false;
+    for (auto& w : workers) {
+        w.join();
     }
 
-    std::lock_guard<std::mutex> lock(mtx_);
-
-    std::ostringstream oss;
-    oss << "SELECT "
-           "DATE_FORMAT(event_time,'%Y-%m-%d %H:%i:%s') AS et, "
-           "talk, callsign, tg "
-           "FROM fmlastheard "
-           "WHERE event_time >= (NOW() - INTERVAL 30 DAY) "
-           "ORDER BY callsign, event_time, id";
-
-    if (mysql_query(conn_, oss.str().c_str()) != 0) {
-        lastError_ = mysql_error(conn_);
-        std::fprintf(stderr, "[FMDB] computeQsoAggregatesLast30Days query failed: %s\n",
-                     lastError_.c_str());
+    // abgebrochene Shards melden "cancelled", der eigentliche Fehler geht vor
+    rows = 0;
+    std::string err;
+    for (unsigned k = 0; k < threads; ++k) {
+        rows += counts[k];
+        if (!errors[k].empty() && (err.empty() || err == "cancelled")) err = errors[k];
+    }
+    if (!err.empty()) lastError_ = err;
+    if (failed) {
         return false;
     }
 
-    MYSQL_RES* res = mysql_store_result(conn_);
-    if (!res) {
-        lastError_ = mysql_error(conn_);
-        std::fprintf(stderr, "[FMDB] computeQsoAggregatesLast30Days store_result failed: %s\n",
-                     lastError_.c_str());
-        return false;
+    for (auto& p : parts) {
+        out.mergeFrom(p);
     }
+    return true;
+}
 
-    const std::time_t now          = std::time(nullptr);
-    const std::time_t sevenDaysAgo = now - 7 * 24 * 60 * 60;
+void FMDatabase::verifyQsoAggregates(const QsoAggregator::Totals& liveTotals,
+                                     std::time_t now) noexcept
+{
+    QsoAggregator scanned;
+    if (!scanQsoAggregates(scanned)) {
+        std::fprintf(stderr, "[FMDB] verify: scan failed: %s\n", lastError_.c_str());
+        return;
+    }
 
-    std::string currentCall;
-    bool        hasOpenStart = false;
-    std::time_t currentStart = 0;
-    int         currentTg    = 0;
+    QsoAggregator::Totals ref;
+    scanned.totals(now, ref);
 
-    MYSQL_ROW row;
-    while ((row = mysql_fetch_row(res)) != nullptr) {
-        const char* etStr = row[0];
-        const char* talk  = row[1];
-        const char* call  = row[2];
-        const char* tgStr = row[3];
+    std::size_t diffs = 0;
+    std::size_t calls = 0;
 
-        if (!etStr || !talk || !call || !tgStr) {
-            continue;
-        }
+    for (std::size_t w = 0; w < QsoAggregator::WindowCount; ++w) {
+        const auto& r = ref.windows[w];
+        const auto& l = liveTotals.windows[w];
 
-        std::time_t t{};
-        if (!parseDateTimeToTimeT(etStr, t)) {
-            continue;
+        // Vektoren können verschieden lang sein (IDs ohne QSO im Fenster)
+        const std::size_t nIds = std::max(r.perCall.size(), l.perCall.size());
+        for (std::size_t id = 0; id < nIds; ++id) {
+            CallAggregate a, b;
+            if (id < r.perCall.size()) a = r.perCall[id];
+            if (id < l.perCall.size()) b = l.perCall[id];
+            if (a.qsoCount > 0 && w == QsoAggregator::Window365d) ++calls;
+            if (a.qsoCount != b.qsoCount || a.totalSeconds != b.totalSeconds) ++diffs;
         }
 
-        int tg = std::atoi(tgStr);
-
-        std::string callStr(call);
-        std::string talkStr(talk);
-
-        // bei neuem Callsign State zurücksetzen
-        if (callStr != currentCall) {
-            currentCall  = callStr;
-            hasOpenStart = false;
+        for (const auto& kv : r.perTgCount) {
+            auto it = l.perTgCount.find(kv.first);
+            if (it == l.perTgCount.end() || it->second != kv.second) ++diffs;
         }
+        if (l.perTgCount.size() != r.perTgCount.size()) ++diffs;
+    }
 
-        if (talkStr == "start") {
-            // mehrfaches start -> letztes gewinnt, alte werden ignoriert
-            currentStart  = t;
-            currentTg     = tg;
-            hasOpenStart  = true;
-        } else if (talkStr == "stop") {
-            if (!hasOpenStart) {
-                // stop ohne passendes start -> ignorieren
-                continue;
-            }
-
-            double dt = std::difftime(t, currentStart);
-            // QSOs < 5s ignorieren
-            if (dt < 5.0) {
-                hasOpenStart = false;
-                continue;
-            }
-
-            // Aggregation pro Callsign
-            auto& agg = perCall[currentCall];
-            agg.qsoCount     += 1;
-            agg.totalSeconds += dt;
-
-            // Aggregation pro TG
-            perTg[currentTg] += dt;
-            perTgCount[currentTg] += 1;
-
-            // Heatmap (nur QSOs mit Startzeit in letzter Woche)
-            if (currentStart >= sevenDaysAgo) {
-                std::tm tm{};
-                localtime_r(&currentStart, &tm);
+    if (liveTotals.heatmapWeek != ref.heatmapWeek) ++diffs;
 
-                int hour = tm.tm_hour;          // 0..23
-                int wday = tm.tm_wday;          // 0=Sonntag..6=Samstag
+    if (diffs == 0) {
+        std::fprintf(stdout, "[FMDB] verify: live aggregates match full scan (%zu calls)\n",
+                     calls);
+        return;
+    }
 
-                // auf 0=Montag..6=Sonntag umbiegen
-                int weekdayIndex = (wday == 0) ? 6 : (wday - 1);
+    // nur melden: der Writer füttert live während des Scans weiter, ein Ersetzen
+    // würde alles verwerfen, was in der Zwischenzeit kam (Abweichungen durch
+    // gerade geschriebene Events sind daher normal, dauerhafte nicht)
+    std::fprintf(stderr, "[FMDB] verify: %zu differences to full scan (not repaired)\n", diffs);
+}
 
-                if (weekdayIndex >= 0 && weekdayIndex < 7 &&
-                    hour >= 0 && hour < 24) {
-                    heatmapWeek[weekdayIndex][hour] += 1;
-                }
-            }
+// Top-Listen über einen begrenzten Heap (TopK), nicht über alle Callsigns
+// sortiert; Namen werden erst für die Gewinner aufgelöst.
+// Bei Gleichstand gewinnt die kleinere ID bzw. TG (feste Reihenfolge).
+template <typename Better>
+std::vector<FMDatabase::CallEntry>
+FMDatabase::topCalls(const std::vector<CallEntry>& calls, Better better)
+{
+    auto cmp = [&better](const CallEntry& a, const CallEntry& b) {
+        if (better(a.second, b.second)) return true;
+        if (better(b.second, a.second)) return false;
+        return a.first < b.first;
+    };
 
-            hasOpenStart = false;
-        }
+    TopK<CallEntry, decltype(cmp)> top(kTopN, cmp);
+    for (const auto& e : calls) {
+        top.offer(e);
     }
-
-    mysql_free_result(res);
-    return true;
+    return top.take();
 }
 
 std::vector<FMCallQsoCount>
-FMDatabase::makeTop10ByQsoCount(const CallAggMap& perCall) const
+FMDatabase::makeTop10ByQsoCount(const std::vector<CallEntry>& calls) const
 {
     std::vector<FMCallQsoCount> result;
-    result.reserve(perCall.size());
 
-    for (const auto& kv : perCall) {
+    auto top = topCalls(calls, [](const CallAggregate& a, const CallAggregate& b) {
+        return a.qsoCount > b.qsoCount;
+    });
+
+    for (const auto& c : top) {
         FMCallQsoCount e;
-        e.callsign = kv.first;
-        e.qsoCount = kv.second.qsoCount;
+        e.callsign = std::string(CallsignDict::name(c.first));
+        e.qsoCount = c.second.qsoCount;
         result.push_back(std::move(e));
     }
-
-    std::sort(result.begin(), result.end(),
-              [](const FMCallQsoCount& a, const FMCallQsoCount& b) {
-                  return a.qsoCount > b.qsoCount;
-              });
-
-    if (result.size() > 10) result.resize(10);
     return result;
 }
 
 std::vector<FMCallDuration>
-FMDatabase::makeTop10ByDuration(const CallAggMap& perCall) const
+FMDatabase::makeTop10ByDuration(const std::vector<CallEntry>& calls) const
 {
     std::vector<FMCallDuration> result;
-    result.reserve(perCall.size());
 
-    for (const auto& kv : perCall) {
+    auto top = topCalls(calls, [](const CallAggregate& a, const CallAggregate& b) {
+        return a.totalSeconds > b.totalSeconds;
+    });
+
+    for (const auto& c : top) {
         FMCallDuration e;
-        e.callsign     = kv.first;
-        e.totalSeconds = kv.second.totalSeconds;
+        e.callsign     = std::string(CallsignDict::name(c.first));
+        e.totalSeconds = c.second.totalSeconds;
         result.push_back(std::move(e));
     }
-
-    std::sort(result.begin(), result.end(),
-              [](const FMCallDuration& a, const FMCallDuration& b) {
-                  return a.totalSeconds > b.totalSeconds;
-              });
-
-    if (result.size() > 10) result.resize(10);
     return result;
 }
 
 std::vector<FMCallScore>
-FMDatabase::makeTop10ByScore(const CallAggMap& perCall) const
+FMDatabase::makeTop10ByScore(const std::vector<CallEntry>& calls) const
 {
     std::vector<FMCallScore> result;
-    result.reserve(perCall.size());
 
-    for (const auto& kv : perCall) {
+    auto score = [](const CallAggregate& a) {
+        return (a.qsoCount * a.totalSeconds) / 100.0;
+    };
+    auto top = topCalls(calls, [&score](const CallAggregate& a, const CallAggregate& b) {
+        return score(a) > score(b);
+    });
+
+    for (const auto& c : top) {
         FMCallScore e;
-        e.callsign     = kv.first;
-        e.qsoCount     = kv.second.qsoCount;
-        e.totalSeconds = kv.second.totalSeconds;
-        e.score        = (e.qsoCount * e.totalSeconds) / 100.0;
+        e.callsign     = std::string(CallsignDict::name(c.first));
+        e.qsoCount     = c.second.qsoCount;
+        e.totalSeconds = c.second.totalSeconds;
+        e.score        = score(c.second);
         result.push_back(std::move(e));
     }
-
-    std::sort(result.begin(), result.end(),
-              [](const FMCallScore& a, const FMCallScore& b) {
-                  return a.score > b.score;
-              });
-
-    if (result.size() > 10) result.resize(10);
     return result;
 }
 
@@ -866,85 +2058,185 @@ std::vector<FMTgDuration>
 FMDatabase::makeTop10TgByDuration(const TgAggMap& perTg,
                                   const TgCountMap& perTgCount) const
 {
-    std::vector<FMTgDuration> result;
-    result.reserve(perTg.size());
+    auto cmp = [](const FMTgDuration& a, const FMTgDuration& b) {
+        if (a.totalSeconds != b.totalSeconds) return a.totalSeconds > b.totalSeconds;
+        return a.tg < b.tg;
+    };
+    TopK<FMTgDuration, decltype(cmp)> top(kTopN, cmp);
 
     for (const auto& kv : perTg) {
-        int tg          = kv.first;
-        double totalSec = kv.second;
-
-        std::uint64_t cnt = 0;
-        if (auto it = perTgCount.find(tg); it != perTgCount.end()) {
-            cnt = it->second;
+        FMTgDuration e;
+        e.tg           = kv.first;
+        e.totalSeconds = kv.second;
+        if (auto it = perTgCount.find(kv.first); it != perTgCount.end()) {
+            e.qsoCount = it->second;
         }
+        top.offer(e);
+    }
+    return top.take();
+}
 
-        FMTgDuration e;
-        e.tg           = tg;
-        e.totalSeconds = totalSec;
-        e.qsoCount     = cnt;    // <--- hier wird qsoCount gesetzt
-        result.push_back(std::move(e));
+void FMDatabase::makeTgLists(const QsoAggregator::WindowTotals& t,
+                             int                     defaultTg,
+                             const std::vector<int>& monitorTgs,
+                             FMStatsWindow&          out) const
+{
+    // Listen für die aktivsten TGs (Dauer) und immer für die konfigurierten
+    auto busier = [](const std::pair<int, double>& a, const std::pair<int, double>& b) {
+        if (a.second != b.second) return a.second > b.second;
+        return a.first < b.first;
+    };
+    TopK<std::pair<int, double>, decltype(busier)> busiest(kMaxTgLists, busier);
+    for (const auto& kv : t.perTg) {
+        busiest.offer(kv);
     }
 
-    std::sort(result.begin(), result.end(),
-              [](const FMTgDuration& a, const FMTgDuration& b) {
-                  return a.totalSeconds > b.totalSeconds;
-              });
+    std::unordered_map<int, std::vector<CallEntry>> byTg;
+    for (const auto& kv : busiest.take()) {
+        byTg[kv.first];
+    }
+    if (defaultTg > 0) byTg[defaultTg];
+    for (int tg : monitorTgs) byTg[tg];
 
-    if (result.size() > 10) result.resize(10);
-    return result;
+    std::unordered_map<int, bool> isMonitored;
+    for (int tg : monitorTgs) isMonitored[tg] = true;
+
+    // ein Durchlauf über perTgCall verteilt auf alle Listen
+    std::unordered_map<std::uint32_t, CallAggregate> monitored;
+    for (const auto& kv : t.perTgCall) {
+        const int           tg = QsoAggregator::keyTg(kv.first);
+        const std::uint32_t id = QsoAggregator::keyCall(kv.first);
+
+        if (auto it = byTg.find(tg); it != byTg.end()) {
+            it->second.emplace_back(id, kv.second);
+        }
+        if (isMonitored.count(tg)) {
+            CallAggregate& m = monitored[id];
+            m.qsoCount     += kv.second.qsoCount;
+            m.totalSeconds += kv.second.totalSeconds;
+        }
+    }
+
+    out.perTg.clear();
+    out.perTg.reserve(byTg.size());
+    for (const auto& kv : byTg) {
+        if (kv.second.empty()) continue;   // keine QSOs im Fenster
+
+        FMTgCallLists l;
+        l.tg                 = kv.first;
+        l.topCallsByCount    = makeTop10ByQsoCount(kv.second);
+        l.topCallsByDuration = makeTop10ByDuration(kv.second);
+        out.perTg.push_back(std::move(l));
+    }
+    std::sort(out.perTg.begin(), out.perTg.end(),
+              [](const FMTgCallLists& a, const FMTgCallLists& b) { return a.tg < b.tg; });
+
+    std::vector<CallEntry> mon(monitored.begin(), monitored.end());
+    out.monitored.topCallsByCount    = makeTop10ByQsoCount(mon);
+    out.monitored.topCallsByDuration = makeTop10ByDuration(mon);
 }
 
-void FMDatabase::statistics() noexcept
+bool FMDatabase::getStatsTgs(int& defaultTg, std::vector<int>& monitorTgs) noexcept
 {
-    // Nur alle 10 Minuten neu berechnen
-    using Clock = std::chrono::steady_clock;
-    static Clock::time_point lastRun;
-    static bool hasLastRun = false;
-
-    Clock::time_point now = Clock::now();
-    if (hasLastRun) {
-        auto diff = std::chrono::duration_cast<std::chrono::minutes>(now - lastRun);
-        if (diff < std::chrono::minutes(10)) {
-            // Letzte Berechnung ist noch keine 10 Minuten her -> ignorieren
-            return;
-        }
+    defaultTg = 0;
+    monitorTgs.clear();
+
+    if (!ensureConn()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (mysql_query(conn_, "SELECT default_tg, monitor_tgs FROM config WHERE id = 1") != 0) {
+        lastError_ = mysql_error(conn_);
+        return false;
+    }
+    MYSQL_RES* res = mysql_store_result(conn_);
+    if (!res) {
+        lastError_ = mysql_error(conn_);
+        return false;
     }
 
-    hasLastRun = true;
-    lastRun = now;
+    if (MYSQL_ROW row = mysql_fetch_row(res)) {
+        if (row[0]) defaultTg = std::atoi(row[0]);
+        if (row[1]) monitorTgs = parseTgList(row[1]);
+    }
+    mysql_free_result(res);
+    return true;
+}
 
-    CallAggMap   perCall;
-    TgAggMap     perTg;
-    TgCountMap   perTgCount;
-    FMQsoHeatmap heatmapWeek;
+// Intervall bestimmt der Aufrufer (Scheduler in main stößt alle 10 Minuten
+// den StatsWorker an, der läuft mit eigener Verbindung im eigenen Thread)
+bool FMDatabase::statistics(QsoAggregator* live, FMStatsSnapshot* snapshot) noexcept
+{
+    QsoAggregator::Totals totals;
+    const std::time_t now = std::time(nullptr);
+
+    if (live) {
+        // laufend mitgeführt, kein Scan nötig
+        live->totals(now, totals);
+        if (ParserSettings::statsVerify) {
+            verifyQsoAggregates(totals, now);
+        }
+    } else {
+        QsoAggregator scanned;
+        if (!scanQsoAggregates(scanned)) {
+            std::fprintf(stderr, "[FMDB] statistics: scanQsoAggregates failed: %s\n",
+                         lastError_.c_str());
+            return false;
+        }
+        scanned.totals(now, totals);
+    }
+    if (cancelled()) return false;
 
-    if (!computeQsoAggregatesLast30Days(perCall, perTg, perTgCount, heatmapWeek)) {
-        std::fprintf(stderr, "[FMDB] statistics: computeQsoAggregatesLast30Days failed: %s\n",
+    // Filter "local"/"monitored" der GUI; ohne config nur die aktivsten TGs
+    int defaultTg = 0;
+    std::vector<int> monitorTgs;
+    if (!getStatsTgs(defaultTg, monitorTgs)) {
+        std::fprintf(stderr, "[FMDB] statistics: reading config TGs failed: %s\n",
                      lastError_.c_str());
-        return;
     }
 
-    // 1–4: Top-Listen bilden
-    auto topCallsByCount    = makeTop10ByQsoCount(perCall);
-    auto topCallsByDuration = makeTop10ByDuration(perCall);
-    auto topCallsByScore    = makeTop10ByScore(perCall);
-    auto topTgByDuration    = makeTop10TgByDuration(perTg, perTgCount);
+    // alle Fenster aus demselben Stand, geschrieben in einer Transaktion
+    std::vector<FMStatsWindow> windows;
+    windows.reserve(QsoAggregator::WindowCount);
+
+    std::vector<CallEntry> calls;
+    for (int w = 0; w < QsoAggregator::WindowCount; ++w) {
+        const auto& t = totals.windows[static_cast<std::size_t>(w)];
+
+        calls.clear();
+        for (std::size_t id = 0; id < t.perCall.size(); ++id) {
+            if (t.perCall[id].qsoCount > 0) {
+                calls.emplace_back(static_cast<std::uint32_t>(id), t.perCall[id]);
+            }
+        }
+
+        FMStatsWindow sw;
+        sw.window             = QsoAggregator::windowName(static_cast<QsoAggregator::Window>(w));
+        sw.topCallsByCount    = makeTop10ByQsoCount(calls);
+        sw.topCallsByDuration = makeTop10ByDuration(calls);
+        sw.topCallsByScore    = makeTop10ByScore(calls);
+        sw.topTgByDuration    = makeTop10TgByDuration(t.perTg, t.perTgCount);
+        makeTgLists(t, defaultTg, monitorTgs, sw);
+        windows.push_back(std::move(sw));
+    }
 
-    // Ergebnisse in fmstats schreiben
-    if (!writeStatisticsToDb(topCallsByCount,
-                             topCallsByDuration,
-                             topCallsByScore,
-                             topTgByDuration,
-                             heatmapWeek)) {
+    if (!writeStatisticsToDb(windows, totals.heatmapWeek)) {
         std::fprintf(stderr, "[FMDB] statistics: writeStatisticsToDb failed: %s\n",
                      lastError_.c_str());
+        return false;
+    }
+
+    if (snapshot) {
+        snapshot->windows     = std::move(windows);
+        snapshot->heatmapWeek = totals.heatmapWeek;
+        snapshot->createdAt   = now;
     }
+    return true;
 }
 
-bool FMDatabase::writeStatisticsToDb(const std::vector<FMCallQsoCount>& topCallsByCount,
-                                     const std::vector<FMCallDuration>& topCallsByDuration,
-                                     const std::vector<FMCallScore>&   topCallsByScore,
-                                     const std::vector<FMTgDuration>&  topTgByDuration,
+bool FMDatabase::writeStatisticsToDb(const std::vector<FMStatsWindow>& windows,
                                      const FMQsoHeatmap&               heatmapWeek) noexcept
 {
     if (!ensureConn()) {
@@ -965,14 +2257,42 @@ bool FMDatabase::writeStatisticsToDb(const std::vector<FMCallQsoCount>& topCalls
         return true;
     };
 
-    if (!execSimple("START TRANSACTION")) {
+    // Neuer Stand komplett in fmstats_new, dann per RENAME TABLE getauscht:
+    // Leser sehen immer einen vollständigen Stand und warten auf keine
+    // Row-Locks, geschrieben wird mit wenigen Multi-Row-INSERTs.
+    // Reste eines abgebrochenen Laufs zuerst weg.
+    if (!execSimple("DROP TABLE IF EXISTS fmstats_new, fmstats_old") ||
+        !execSimple("CREATE TABLE fmstats_new LIKE fmstats")) {
         return false;
     }
 
-    if (!execSimple("DELETE FROM fmstats")) {
-        execSimple("ROLLBACK");
-        return false;
-    }
+    auto discard = [&]() {
+        execSimple("DROP TABLE IF EXISTS fmstats_new");
+    };
+
+    static const char* kInsertHead =
+        "INSERT INTO fmstats_new "
+        "(metric, `window`, scope, rank, callsign, tg, weekday, hour, "
+        " qso_count, total_seconds, score, metric_value) VALUES ";
+
+    std::string sql;
+    sql.reserve(kStatsInsertBytes + 1024);
+    std::size_t pending = 0;
+
+    auto flush = [&]() -> bool {
+        if (cancelled()) {
+            lastError_ = "cancelled";
+            return false;
+        }
+        if (pending == 0) return true;
+        bool ok = execSimple(sql.c_str());
+        sql.clear();
+        pending = 0;
+        return ok;
+    };
+
+    std::string window;
+    std::string scope = "all";
 
     auto insertRow =
         [&](const std::string& metric,
@@ -986,62 +2306,42 @@ bool FMDatabase::writeStatisticsToDb(const std::vector<FMCallQsoCount>& topCalls
             const double*      score,
             const double*      value) -> bool
     {
-        std::ostringstream oss;
-        oss << "INSERT INTO fmstats "
-               "(metric, rank, callsign, tg, weekday, hour, "
-               " qso_count, total_seconds, score, metric_value) VALUES (";
-
-        // metric
-        oss << "'" << escape(metric) << "',";
-
-        // rank
-        if (rank >= 0) oss << rank;
-        else           oss << "NULL";
-        oss << ",";
-
-        // callsign
-        if (callsign) oss << "'" << escape(*callsign) << "'";
-        else          oss << "NULL";
-        oss << ",";
-
-        // tg
-        if (tg) oss << *tg;
-        else    oss << "NULL";
-        oss << ",";
-
-        // weekday
-        if (weekday) oss << *weekday;
-        else         oss << "NULL";
-        oss << ",";
-
-        // hour
-        if (hour) oss << *hour;
-        else      oss << "NULL";
-        oss << ",";
-
-        // qso_count
-        if (qsoCount) oss << static_cast<unsigned long long>(*qsoCount);
-        else          oss << "NULL";
-        oss << ",";
-
-        // total_seconds
-        if (totalSeconds) oss << *totalSeconds;
-        else              oss << "NULL";
-        oss << ",";
-
-        // score
-        if (score) oss << *score;
-        else       oss << "NULL";
-        oss << ",";
-
-        // metric_value
-        if (value) oss << *value;
-        else       oss << "NULL";
-
-        oss << ")";
-
-        if (mysql_query(conn_, oss.str().c_str()) != 0) {
-            lastError_ = mysql_error(conn_);
+        // NULL, wenn kein Wert übergeben wurde
+        sql += pending == 0 ? kInsertHead : ",";
+        sql += "('";
+        sql += escape(metric);
+        sql += "','";
+        sql += escape(window);
+        sql += "','";
+        sql += escape(scope);
+        sql += "',";
+        appendSqlInt(sql, rank >= 0 ? &rank : nullptr);
+        sql += ",";
+        if (callsign) {
+            sql += "'";
+            sql += escape(*callsign);
+            sql += "'";
+        } else {
+            sql += "NULL";
+        }
+        sql += ",";
+        appendSqlInt(sql, tg);
+        sql += ",";
+        appendSqlInt(sql, weekday);
+        sql += ",";
+        appendSqlInt(sql, hour);
+        sql += ",";
+        sql += qsoCount ? std::to_string(*qsoCount) : std::string("NULL");
+        sql += ",";
+        appendSqlDouble(sql, totalSeconds);
+        sql += ",";
+        appendSqlDouble(sql, score);
+        sql += ",";
+        appendSqlDouble(sql, value);
+        sql += ")";
+        ++pending;
+
+        if (sql.size() >= kStatsInsertBytes && !flush()) {
             std::fprintf(stderr, "[FMDB] writeStatisticsToDb INSERT failed: %s\n",
                          lastError_.c_str());
             return false;
@@ -1049,102 +2349,143 @@ bool FMDatabase::writeStatisticsToDb(const std::vector<FMCallQsoCount>& topCalls
         return true;
     };
 
-    // 1) Top 10 Callsigns nach QSO-Anzahl
-    for (std::size_t i = 0; i < topCallsByCount.size(); ++i) {
-        const auto& e = topCallsByCount[i];
-        int rank      = static_cast<int>(i + 1);
-        std::uint64_t qso = e.qsoCount;
-        double value  = static_cast<double>(qso);
-
-        if (!insertRow("top_calls_qso",
-                       rank,
-                       &e.callsign,
-                       nullptr,
-                       nullptr,
-                       nullptr,
-                       &qso,
-                       nullptr,
-                       nullptr,
-                       &value)) {
-            execSimple("ROLLBACK");
-            return false;
+    for (const auto& sw : windows) {
+        window = sw.window;
+
+        // 1) Top 10 Callsigns nach QSO-Anzahl
+        for (std::size_t i = 0; i < sw.topCallsByCount.size(); ++i) {
+            const auto& e = sw.topCallsByCount[i];
+            int rank      = static_cast<int>(i + 1);
+            std::uint64_t qso = e.qsoCount;
+            double value  = static_cast<double>(qso);
+
+            if (!insertRow("top_calls_qso",
+                           rank,
+                           &e.callsign,
+                           nullptr,
+                           nullptr,
+                           nullptr,
+                           &qso,
+                           nullptr,
+                           nullptr,
+                           &value)) {
+                discard();
+                return false;
+            }
         }
-    }
 
-    // 2) Top 10 Callsigns nach Gesamtdauer (Sekunden)
-    for (std::size_t i = 0; i < topCallsByDuration.size(); ++i) {
-        const auto& e = topCallsByDuration[i];
-        int rank      = static_cast<int>(i + 1);
-        double total  = e.totalSeconds;
-        double value  = total;
-
-        if (!insertRow("top_calls_duration",
-                       rank,
-                       &e.callsign,
-                       nullptr,
-                       nullptr,
-                       nullptr,
-                       nullptr,
-                       &total,
-                       nullptr,
-                       &value)) {
-            execSimple("ROLLBACK");
-            return false;
+        // 2) Top 10 Callsigns nach Gesamtdauer (Sekunden)
+        for (std::size_t i = 0; i < sw.topCallsByDuration.size(); ++i) {
+            const auto& e = sw.topCallsByDuration[i];
+            int rank      = static_cast<int>(i + 1);
+            double total  = e.totalSeconds;
+            double value  = total;
+
+            if (!insertRow("top_calls_duration",
+                           rank,
+                           &e.callsign,
+                           nullptr,
+                           nullptr,
+                           nullptr,
+                           nullptr,
+                           &total,
+                           nullptr,
+                           &value)) {
+                discard();
+                return false;
+            }
         }
-    }
 
-    // 3) Top 10 Callsigns nach Score
-    for (std::size_t i = 0; i < topCallsByScore.size(); ++i) {
-        const auto& e = topCallsByScore[i];
-        int rank      = static_cast<int>(i + 1);
-        std::uint64_t qso = e.qsoCount;
-        double total  = e.totalSeconds;
-        double sc     = e.score;
-        double value  = sc;
-
-        if (!insertRow("top_calls_score",
-                       rank,
-                       &e.callsign,
-                       nullptr,
-                       nullptr,
-                       nullptr,
-                       &qso,
-                       &total,
-                       &sc,
-                       &value)) {
-            execSimple("ROLLBACK");
-            return false;
+        // 3) Top 10 Callsigns nach Score
+        for (std::size_t i = 0; i < sw.topCallsByScore.size(); ++i) {
+            const auto& e = sw.topCallsByScore[i];
+            int rank      = static_cast<int>(i + 1);
+            std::uint64_t qso = e.qsoCount;
+            double total  = e.totalSeconds;
+            double sc     = e.score;
+            double value  = sc;
+
+            if (!insertRow("top_calls_score",
+                           rank,
+                           &e.callsign,
+                           nullptr,
+                           nullptr,
+                           nullptr,
+                           &qso,
+                           &total,
+                           &sc,
+                           &value)) {
+                discard();
+                return false;
+            }
         }
-    }
 
-    // 4) Top 10 TG nach Dauer
-    for (std::size_t i = 0; i < topTgByDuration.size(); ++i) {
-        const auto& e = topTgByDuration[i];
-        int rank      = static_cast<int>(i + 1);
-        int tg        = e.tg;
-        double total  = e.totalSeconds;
-        double value  = total;
-
-        // NEU: QSO-Anzahl für diese TG
-        std::uint64_t qso = e.qsoCount;
-
-        if (!insertRow("top_tg_duration",
-                    rank,          // rank
-                    nullptr,       // callsign
-                    &tg,           // tg
-                    nullptr,       // weekday
-                    nullptr,       // hour
-                    &qso,          // qso_count
-                    &total,        // total_seconds
-                    nullptr,       // score
-                    &value)) {     // metric_value (hier = total)
-            execSimple("ROLLBACK");
+        // 4) Top 10 TG nach Dauer
+        for (std::size_t i = 0; i < sw.topTgByDuration.size(); ++i) {
+            const auto& e = sw.topTgByDuration[i];
+            int rank      = static_cast<int>(i + 1);
+            int tg        = e.tg;
+            double total  = e.totalSeconds;
+            double value  = total;
+
+            // NEU: QSO-Anzahl für diese TG
+            std::uint64_t qso = e.qsoCount;
+
+            if (!insertRow("top_tg_duration",
+                        rank,          // rank
+                        nullptr,       // callsign
+                        &tg,           // tg
+                        nullptr,       // weekday
+                        nullptr,       // hour
+                        &qso,          // qso_count
+                        &total,        // total_seconds
+                        nullptr,       // score
+                        &value)) {     // metric_value (hier = total)
+                discard();
+                return false;
+            }
+        }
+
+        // 6) Top 10 Callsigns je TG und über die Monitor-TGs (Filter der GUI)
+        auto insertTgLists = [&](const FMTgCallLists& l, const int* tg) -> bool {
+            for (std::size_t i = 0; i < l.topCallsByCount.size(); ++i) {
+                const auto& e = l.topCallsByCount[i];
+                std::uint64_t qso = e.qsoCount;
+                double value      = static_cast<double>(qso);
+                if (!insertRow("top_calls_qso", static_cast<int>(i + 1), &e.callsign, tg,
+                               nullptr, nullptr, &qso, nullptr, nullptr, &value)) {
+                    return false;
+                }
+            }
+            for (std::size_t i = 0; i < l.topCallsByDuration.size(); ++i) {
+                const auto& e = l.topCallsByDuration[i];
+                double total  = e.totalSeconds;
+                if (!insertRow("top_calls_duration", static_cast<int>(i + 1), &e.callsign, tg,
+                               nullptr, nullptr, nullptr, &total, nullptr, &total)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        scope = "tg";
+        for (const auto& l : sw.perTg) {
+            if (!insertTgLists(l, &l.tg)) {
+                discard();
+                return false;
+            }
+        }
+        scope = "monitored";
+        if (!insertTgLists(sw.monitored, nullptr)) {
+            discard();
             return false;
         }
+        scope = "all";
     }
 
     // 5) Heatmap 24 x 7 (Anzahl QSOs pro Stunde, letzte Woche)
     // weekday: 0=Mo..6=So, hour: 0..23
+    window = QsoAggregator::windowName(QsoAggregator::Window7d);
     for (int wd = 0; wd < 7; ++wd) {
         for (int h = 0; h < 24; ++h) {
             std::uint64_t cnt = heatmapWeek[wd][h];
@@ -1162,16 +2503,25 @@ bool FMDatabase::writeStatisticsToDb(const std::vector<FMCallQsoCount>& topCalls
                            nullptr,
                            nullptr,
                            &value)) {
-                execSimple("ROLLBACK");
+                discard();
                 return false;
             }
         }
     }
 
-    if (!execSimple("COMMIT")) {
-        execSimple("ROLLBACK");
+    if (!flush()) {
+        std::fprintf(stderr, "[FMDB] writeStatisticsToDb INSERT failed: %s\n",
+                     lastError_.c_str());
+        discard();
+        return false;
+    }
+
+    // atomar: wer fmstats liest, sieht den alten oder den neuen Stand
+    if (!execSimple("RENAME TABLE fmstats TO fmstats_old, fmstats_new TO fmstats")) {
+        discard();
         return false;
     }
+    execSimple("DROP TABLE IF EXISTS fmstats_old");
 
     return true;
 }
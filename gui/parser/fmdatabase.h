@@ -6,8 +6,16 @@
 #include <mutex>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <unordered_map>
+#include <utility>
+
+#include "fm_event.h"
+#include "active_talkers.h"
+#include "last_heard.h"
+#include "qso_aggregator.h"
+#include "parser_settings.h"
 
 struct FMCallQsoCount {
     std::string   callsign;
@@ -32,23 +40,81 @@ struct FMTgDuration {
     double totalSeconds = 0.0;
 };
 
-using FMQsoHeatmap = std::array<std::array<std::uint32_t, 24>, 7>; // [weekday][hour], weekday: 0=Mo..6=So
+// Top-Callsigns innerhalb einer TG bzw. der Monitor-TGs
+struct FMTgCallLists {
+    int                         tg = 0;   // bei scope 'monitored' unbenutzt
+    std::vector<FMCallQsoCount> topCallsByCount;
+    std::vector<FMCallDuration> topCallsByDuration;
+};
+
+// Top-Listen eines Zeitfensters (fmstats.window)
+struct FMStatsWindow {
+    const char*                 window = "";   // "24h", "7d", "30d", "365d"
+    std::vector<FMCallQsoCount> topCallsByCount;
+    std::vector<FMCallDuration> topCallsByDuration;
+    std::vector<FMCallScore>    topCallsByScore;
+    std::vector<FMTgDuration>   topTgByDuration;
+
+    std::vector<FMTgCallLists>  perTg;       // fmstats.scope = 'tg', aufsteigend nach tg
+    FMTgCallLists               monitored;   // fmstats.scope = 'monitored'
+};
+
+// alles, was ein Statistik-Lauf nach fmstats schreibt (für LiveApi im Speicher)
+struct FMStatsSnapshot {
+    std::vector<FMStatsWindow> windows;   // Reihenfolge wie QsoAggregator::Window
+    FMQsoHeatmap               heatmapWeek{};
+    std::time_t                createdAt = 0;
+};
 
 class FMDatabase {
 public:
+    // verbindet sofort; schlägt das fehl, bleibt die Instanz ohne Verbindung
+    // und jeder Aufruf versucht es erneut (kein exit mehr)
     FMDatabase();
     ~FMDatabase();
 
     FMDatabase(const FMDatabase&) = delete;
     FMDatabase& operator=(const FMDatabase&) = delete;
 
-    // Ein einzelnes MQTT-Event eintragen + fmstatus pflegen
+    // Verbindung steht (oder ließ sich gerade wieder aufbauen)
+    bool available() noexcept;
+
+    // Ein einzelnes MQTT-Event in fmlastheard eintragen
     bool insertEvent(const std::string& timeStr,
                      const std::string& talk,
                      const std::string& call,
                      const std::string& tg,
                      const std::string& server) noexcept;
 
+    // mehrere Talk-Events in einer Transaktion, fmlastheard als ein Multi-Row-INSERT;
+    // committed bekommt nach dem COMMIT die neuen fmqso-Zeilen angehängt
+    bool insertEvents(const std::vector<FMEvent>& events,
+                      std::vector<LastHeardQso>* committed = nullptr) noexcept;
+
+    // fmstatus aus dem In-Memory-Tracker spiegeln (je ein Statement für
+    // alle neuen/geänderten und alle entfernten Stationen)
+    bool syncStatus(const std::vector<ActiveTalker>& upserts,
+                    const std::vector<std::string>&  removals) noexcept;
+
+    // fmstatus leeren (beim Start, der Tracker beginnt leer)
+    bool clearStatus() noexcept;
+
+    // timeStr: "HH:MM:SS" oder "YYYY-MM-DD HH:MM:SS" -> "YYYY-MM-DD HH:MM:SS"
+    static std::string makeDateTime(const std::string& timeStr) noexcept;
+
+    // Cache "letzter talk-Wert je Callsign" aus fmlastheard vorbelegen,
+    // dabei auch die offenen starts für fmqso.
+    // Nur sinnvoll für die Instanz, die fmlastheard schreibt (DbWriter).
+    bool warmLastTalkCache() noexcept;
+
+    // fmqso einmalig aus fmlastheard füllen (Stand in fmparser_state,
+    // abgebrochene Läufe beginnen neu); danach hält insertEvents fmqso aktuell
+    bool backfillQsos() noexcept;
+
+    // LastHeard vorbelegen: je TG die letzten LastHeard::kRows QSOs aus fmqso
+    // und alle Standorte aus nodes
+    bool loadLastHeard(LastHeard& out) noexcept;
+
     bool upsertNode(const std::string& callsign,
                     const std::string& location,
                     const std::string& locator,
@@ -63,8 +129,33 @@ public:
                       int defaultTg,
                       const std::string& monitorTgs) noexcept;
 
-    // Haupt-Statistikfunktion, aus main loop aufrufbar
-    void statistics() noexcept;
+    // Retention: höchstens maxRows Zeilen aus fmlastheard (danach fmqso) löschen,
+    // die älter als days Tage sind; deleted = tatsächlich gelöschte Zeilen
+    bool deleteExpiredChunk(unsigned days,
+                            std::size_t maxRows,
+                            std::uint64_t& deleted) noexcept;
+
+    // Zähler aus SHOW GLOBAL STATUS (z.B. "Questions"), für Benchmarks
+    bool globalStatus(const char* name, std::uint64_t& value) noexcept;
+
+    // Haupt-Statistikfunktion, vom StatsWorker aufgerufen.
+    // live = laufend mitgeführte Aggregate (DB-Writer); nullptr -> Vollscan
+    // false -> fehlgeschlagen oder abgebrochen, fmstats unverändert
+    // snapshot bekommt bei Erfolg den geschriebenen Stand
+    bool statistics(QsoAggregator* live, FMStatsSnapshot* snapshot = nullptr) noexcept;
+
+    // gesetzt -> Scan und Statistik brechen an der nächsten Prüfstelle ab
+    void setCancelFlag(const std::atomic<bool>* flag) noexcept { cancel_ = flag; }
+
+    // Vollscan über fmlastheard (Fenster des QsoAggregator) -> out
+    // (Rebuild beim Start und Verify-Modus); rows = gelesene Zeilen.
+    // threads > 1: Callsigns per Hash auf so viele Shards verteilt, jeder mit
+    // eigener Verbindung und eigenem Thread; 0 = ParserSettings::statsThreads
+    bool scanQsoAggregates(QsoAggregator& out, std::uint64_t* rows = nullptr,
+                           unsigned threads = 0) noexcept;
+
+    // Spitzenwert Resident Set Size des Prozesses in kB (getrusage)
+    static long peakRssKb() noexcept;
 
     // Struktur für die config-Zeile
     struct ConfigRow {
@@ -94,74 +185,165 @@ public:
     bool getConfig(ConfigRow& out) noexcept;
 
 private:
-    bool connect() noexcept;
+    // neu verbinden, Schema prüfen, CallsignDict laden (Aufrufer hält mtx_)
+    bool connectLocked() noexcept;
     bool ensureSchema() noexcept;
+
+    // neue Verbindung mit den Zugangsdaten dieser Instanz (nullptr + err bei Fehler)
+    MYSQL* openConnection(std::string& err) const noexcept;
     bool ensureConn() noexcept;
 
-    // fmlastheard begrenzen
-    bool pruneIfNeeded() noexcept;
+    // Hilfsfunktionen
+    std::string escape(const std::string& in) noexcept;
 
-    // fmstatus: aktive Stationen pflegen
-    bool updateStatus(const std::string& dt,
-                      const std::string& talk,
-                      const std::string& call,
-                      int tg,
-                      const std::string& server) noexcept;
+    // SELECT ungepuffert (mysql_use_result) zeilenweise an onRow(MYSQL_ROW);
+    // Speicher bleibt konstant, egal wie groß das Ergebnis ist.
+    // Aufrufer hält mtx_; onRow darf keine weiteren Queries absetzen.
+    // Liefert onRow bool, beendet false den Durchlauf (Ergebnis: false).
+    template <typename Fn>
+    bool streamQuery(const char* what, const char* sql, Fn&& onRow,
+                     std::uint64_t& rows) noexcept;
+
+    // dasselbe auf einer beliebigen Verbindung (Shards von scanQsoAggregates)
+    template <typename Fn>
+    static bool streamQueryOn(MYSQL* c, const char* what, const char* sql, Fn&& onRow,
+                              std::uint64_t& rows, std::string& err) noexcept;
+
+    // scanQsoAggregates mit threads Shards, ohne conn_
+    bool scanQsoAggregatesSharded(QsoAggregator& out, const char* cutoff,
+                                  unsigned threads, std::uint64_t& rows) noexcept;
+
+    // Server-seitige Prepared Statements für die heißen Pfade.
+    // Werden beim ersten Gebrauch angelegt und nach einem Reconnect neu vorbereitet.
+    enum StmtId {
+        StmtInsertHeard1 = 0,   // fmlastheard, 1/4/16/64 Zeilen pro INSERT
+        StmtInsertHeard4,
+        StmtInsertHeard16,
+        StmtInsertHeard64,
+        StmtInsertQso1,         // fmqso, 1/4/16/64 Zeilen pro INSERT
+        StmtInsertQso4,
+        StmtInsertQso16,
+        StmtInsertQso64,
+        StmtLastTalk,           // letzter talk-Wert eines Callsigns
+        StmtNodeReplace,
+        StmtCount
+    };
 
-    // Einträge, die länger als 3 Minuten nicht aktualisiert wurden, löschen
-    bool cleanupStatus() noexcept;
+    struct HeardRow {
+        std::string   dt;
+        std::string   talk;
+        std::string   call;
+        std::uint64_t callId = 0;   // CallsignDict
+        int           tg = 0;
+        std::string   server;
+    };
 
-    // Hilfsfunktionen
-    std::string makeDateTime(const std::string& timeStr) noexcept;
-    std::string escape(const std::string& in) noexcept;
+    // abgeschlossenes QSO (ein stop mit passendem start) für fmqso
+    struct QsoRow {
+        std::string   call;
+        std::uint64_t callId = 0;
+        int           tg = 0;
+        std::string   server;
+        std::string   startDt;           // leer -> kein start gefunden (NULL)
+        std::string   endDt;
+        std::uint64_t durationSec = 0;
+        bool          hasDuration = false;
+    };
+
+    MYSQL_STMT* stmt(StmtId id) noexcept;
+    bool execStmt(StmtId id, MYSQL_BIND* params) noexcept;
+    void closeStatements() noexcept;
+
+    bool insertHeardRows(const std::vector<HeardRow>& rows) noexcept;
+    bool insertQsoRows(const std::vector<QsoRow>& rows) noexcept;
+
+    // CallsignDict <-> Tabelle callsigns (Aufrufer hält mtx_)
+    bool insertCallsigns(std::uint32_t from, std::uint32_t to) noexcept;
+    bool loadCallsigns() noexcept;
+    // head + (id, callsign, country_code), ... + tail für ids
+    bool writeCallsigns(const std::vector<std::uint32_t>& ids, const char* head,
+                        const char* tail) noexcept;
+    bool queryLastTalk(const std::string& call, std::string& lastTalk) noexcept;
+    bool queryValue(const char* sql, std::string& out) noexcept;
+    bool setBackfillState(const char* value) noexcept;   // fmparser_state.qso_backfill
+
+    // callsign -> letzter Eintrag in fmlastheard war "stop"
+    // (ersetzt die SELECT-Abfrage pro stop-Event, DB nur noch bei Cache-Miss)
+    std::unordered_map<std::string, bool> lastTalkIsStop_;
+
+    // offene starts für fmqso: qsoKey(call, tg, server) -> event_time des letzten start
+    // (wie die frühere Unterabfrage in api.php: letzter start mit gleichem Callsign/TG/Server)
+    std::unordered_map<std::string, std::string> openQsos_;
+    static std::string qsoKey(const std::string& call, int tg, const std::string& server);
+
+    std::array<MYSQL_STMT*, StmtCount> stmts_{};
+    unsigned long stmtThreadId_ = 0;   // Verbindung, für die stmts_ vorbereitet wurden
+
+    // Transaktion von insertEvents: Auto-Reconnect aus, execStmt wiederholt
+    // bei Verbindungsverlust nicht (Aufrufer hält mtx_)
+    bool beginTxn() noexcept;
+    bool endTxn(bool commit) noexcept;   // commit = false -> ROLLBACK
+    bool          inTxn_     = false;
+    unsigned long txnThread_ = 0;
 
     MYSQL* conn_ = nullptr;
     std::string lastError_;
 
+    const std::atomic<bool>* cancel_ = nullptr;   // setCancelFlag()
+    bool cancelled() const noexcept { return cancel_ && cancel_->load(); }
+
     std::mutex mtx_;
 
     const std::string dbUser_       = "svxlink";
     const std::string dbPass_       = "";
-    const std::string dbName_       = "mmdvmdb";
+    const std::string dbName_       = ParserSettings::dbName;
     const std::string dbUnixSocket_ = "/run/mysqld/mysqld.sock";
     const unsigned int dbPort_      = 0; // 0 = über Unix-Socket
 
     // für die Statistik
-    // Aggregation der QSOs der letzten 30 Tage
-    struct CallAggregate {
-        std::uint64_t qsoCount     = 0;
-        double        totalSeconds = 0.0;
-    };
+    // Aggregation der QSOs je Fenster (24h, 7d, 30d, 365d)
+    using CallAggregate = QsoAggregator::CallAggregate;
+    using CallAggVec    = QsoAggregator::CallAggVec;
+    using TgAggMap      = QsoAggregator::TgAggMap;
+    using TgCountMap    = QsoAggregator::TgCountMap;
+
+    // Vergleich live <-> Vollscan, Abweichungen werden nur gemeldet
+    void verifyQsoAggregates(const QsoAggregator::Totals& liveTotals, std::time_t now) noexcept;
 
-    using CallAggMap = std::unordered_map<std::string, CallAggregate>;
-    using TgAggMap   = std::unordered_map<int, double>;
-    using TgCountMap = std::unordered_map<int, std::uint64_t>;
+    static constexpr std::size_t kTopN       = 10;   // Einträge je Top-Liste
+    static constexpr std::size_t kMaxTgLists = 50;   // Listen pro TG: die aktivsten + konfigurierte
 
-    bool computeQsoAggregatesLast30Days(CallAggMap&   perCall,
-                                    TgAggMap&     perTg,
-                                    TgCountMap&   perTgCount,
-                                    FMQsoHeatmap& heatmapWeek) noexcept;
+    using CallEntry = std::pair<std::uint32_t, CallAggregate>;   // Callsign-ID, Summen
+
+    template <typename Better>
+    static std::vector<CallEntry> topCalls(const std::vector<CallEntry>& calls, Better better);
 
     std::vector<FMCallQsoCount>
-    makeTop10ByQsoCount(const CallAggMap& perCall) const;
+    makeTop10ByQsoCount(const std::vector<CallEntry>& calls) const;
 
     std::vector<FMCallDuration>
-    makeTop10ByDuration(const CallAggMap& perCall) const;
+    makeTop10ByDuration(const std::vector<CallEntry>& calls) const;
 
     std::vector<FMCallScore>
-    makeTop10ByScore(const CallAggMap& perCall) const;
+    makeTop10ByScore(const std::vector<CallEntry>& calls) const;
+
+    // Top-Callsigns je TG und über die Monitor-TGs aus perTgCall
+    void makeTgLists(const QsoAggregator::WindowTotals& t,
+                     int                     defaultTg,
+                     const std::vector<int>& monitorTgs,
+                     FMStatsWindow&          out) const;
+
+    // default_tg und monitor_tgs aus config (ohne das Reboot-Flag anzufassen)
+    bool getStatsTgs(int& defaultTg, std::vector<int>& monitorTgs) noexcept;
 
     std::vector<FMTgDuration>
     makeTop10TgByDuration(const TgAggMap& perTg,
                           const TgCountMap& perTgCount) const;
 
+    // schreibt den kompletten Stand nach fmstats_new und tauscht per RENAME TABLE;
+    // INSERTs werden bei kStatsInsertBytes geteilt (unter max_allowed_packet)
+    static constexpr std::size_t kStatsInsertBytes = 256 * 1024;
 
-    // kleiner Helper für DATETIME → time_t
-    static bool parseDateTimeToTimeT(const char* s, std::time_t& out) noexcept;
-
-    bool writeStatisticsToDb(const std::vector<FMCallQsoCount>& topCallsByCount,
-                             const std::vector<FMCallDuration>& topCallsByDuration,
-                             const std::vector<FMCallScore>&   topCallsByScore,
-                             const std::vector<FMTgDuration>&  topTgByDuration,
+    bool writeStatisticsToDb(const std::vector<FMStatsWindow>& windows,
                              const FMQsoHeatmap&               heatmapWeek) noexcept;
 };
@@ -0,0 +1,463 @@
+// fmreplay.cpp
+// Spielt einen MQTT-Mitschnitt (capture_file, siehe mqtt_capture.h) durch die
+// komplette Ingest-Pipeline (Parser -> Queue -> DbWriter -> MariaDB) und misst
+// Durchsatz, Latenz pro Event (Empfang bis in der DB) und DB-Queries pro Event.
+//
+//   make replay
+//   ./FMreplay <capture> [--speed 1|N|max] [--db NAME] [--mqtt HOST[:PORT]]
+//   ./FMreplay --seed N [--seed-days D] [--scan] [--scan-bench T] [--db NAME]
+//
+// --seed N legt N synthetische QSOs (start/stop) über die letzten D Tage an
+// (Default 29, für die Jahresstatistik --seed-days 365),
+// --scan misst den Statistik-Vollscan (Zeilen, Zeit, Peak-RSS),
+// --scan-bench T misst ihn mit 1..T Threads (stats_threads) und prüft, dass
+// jeder Lauf dieselben Summen liefert wie der mit einem Thread.
+//
+// Ohne --mqtt gehen die Nachrichten direkt an MqttListener::handleMessage().
+// Mit --mqtt werden sie an einen (lokalen) Broker publiziert und kommen über
+// den normalen MQTT-Weg wieder herein.
+// Die Ziel-DB wird beschrieben: eigene Benchmark-DB nehmen (Default fmbench),
+// z.B. CREATE DATABASE fmbench; GRANT ALL PRIVILEGES ON fmbench.* TO 'svxlink'@'localhost';
+// Queries/Event zählt "Questions" des ganzen Servers -> nur auf einer ruhigen Instanz messen.
+
+#include "MqttListener.h"
+#include "country_prefixes.h"
+#include "mqtt_capture.h"
+#include "fmdatabase.h"
+#include "parser_settings.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mosquitto.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void usage()
+{
+    std::cerr << "usage: FMreplay [<capture>] [--speed 1|N|max] [--db NAME] [--mqtt HOST[:PORT]]\n"
+                 "                [--seed N] [--seed-days D] [--scan] [--scan-bench T]\n";
+}
+
+// synthetische QSOs, zeitlich aufsteigend, damit die stop-Erkennung passt
+bool seedHeard(FMDatabase& db, std::uint64_t pairs, unsigned days)
+{
+    const std::time_t now   = std::time(nullptr);
+    const std::time_t first = now - static_cast<std::time_t>(days) * 24 * 3600;
+    const double      step  = static_cast<double>(now - 60 - first) / static_cast<double>(pairs);
+    static const char* tgs[] = {"262", "2620", "91", "9", "26200", "2328"};
+
+    auto fmt = [](std::time_t t) {
+        char buf[32];
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+        return std::string(buf);
+    };
+
+    std::vector<FMEvent> batch;
+    batch.reserve(1000);
+
+    auto t0 = Clock::now();
+    for (std::uint64_t i = 0; i < pairs; ++i) {
+        std::time_t start = first + static_cast<std::time_t>(static_cast<double>(i) * step);
+        std::time_t stop  = start + 5 + static_cast<std::time_t>(i * 7919 % 300);
+
+        FMEvent ev;
+        ev.kind   = FMEvent::Kind::Talk;
+        ev.call   = "DB" + std::to_string(i % 2000) + "SY";
+        ev.tg     = tgs[i % (sizeof(tgs) / sizeof(tgs[0]))];
+        ev.server = "1";
+
+        ev.talk = "start";
+        ev.time = fmt(start);
+        batch.push_back(ev);
+
+        ev.talk = "stop";
+        ev.time = fmt(stop);
+        batch.push_back(std::move(ev));
+
+        if (batch.size() >= 1000 || i + 1 == pairs) {
+            if (!db.insertEvents(batch)) {
+                std::cerr << "[FMreplay] seed insert failed after " << i << " QSOs\n";
+                return false;
+            }
+            batch.clear();
+        }
+    }
+
+    std::printf("[FMreplay] seeded %llu QSOs (%llu rows) in %.1f s\n",
+                static_cast<unsigned long long>(pairs),
+                static_cast<unsigned long long>(pairs * 2),
+                std::chrono::duration<double>(Clock::now() - t0).count());
+    return true;
+}
+
+// Summen über alle Fenster und die Heatmap, zum Vergleich der Scan-Läufe
+struct ScanDigest {
+    std::uint64_t qsos    = 0;
+    double        seconds = 0.0;
+    std::size_t   tgCalls = 0;
+    std::uint64_t heatmap = 0;
+
+    bool operator==(const ScanDigest& o) const
+    {
+        return qsos == o.qsos && seconds == o.seconds &&
+               tgCalls == o.tgCalls && heatmap == o.heatmap;
+    }
+};
+
+ScanDigest digest(QsoAggregator& agg, std::time_t now)
+{
+    QsoAggregator::Totals t;
+    agg.totals(now, t);
+
+    ScanDigest d;
+    for (const auto& w : t.windows) {
+        for (const auto& c : w.perCall) {
+            d.qsos    += c.qsoCount;
+            d.seconds += c.totalSeconds;
+        }
+        d.tgCalls += w.perTgCall.size();
+    }
+    for (const auto& day : t.heatmapWeek) {
+        for (std::uint32_t v : day) d.heatmap += v;
+    }
+    return d;
+}
+
+// Vollscan mit 1..maxThreads Threads
+bool scanBench(FMDatabase& db, unsigned maxThreads)
+{
+    const std::time_t now = std::time(nullptr);
+    double     baseSec = 0.0;
+    ScanDigest ref;
+
+    for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+        QsoAggregator agg;
+        std::uint64_t rows = 0;
+
+        auto t0 = Clock::now();
+        if (!db.scanQsoAggregates(agg, &rows, threads)) {
+            return false;
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        ScanDigest d = digest(agg, now);
+        if (threads == 1) {
+            baseSec = sec;
+            ref     = d;
+        }
+
+        std::printf("[FMreplay] scan-bench: %2u threads  %10llu rows  %8.3f s  %10.0f rows/s  "
+                    "speedup %.2fx%s\n",
+                    threads, static_cast<unsigned long long>(rows), sec,
+                    sec > 0.0 ? static_cast<double>(rows) / sec : 0.0,
+                    sec > 0.0 ? baseSec / sec : 0.0,
+                    d == ref ? "" : "  MISMATCH");
+        if (!(d == ref)) {
+            std::fprintf(stderr, "[FMreplay] scan-bench: %u threads: %llu QSOs, 1 thread: %llu\n",
+                         threads, static_cast<unsigned long long>(d.qsos),
+                         static_cast<unsigned long long>(ref.qsos));
+            return false;
+        }
+    }
+    std::printf("[FMreplay] scan-bench: %u cores available\n", std::thread::hardware_concurrency());
+    return true;
+}
+
+double percentileMs(std::vector<std::uint64_t>& v, double p)
+{
+    if (v.empty()) return 0.0;
+    std::size_t idx = static_cast<std::size_t>(p * static_cast<double>(v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(idx), v.end());
+    return static_cast<double>(v[idx]) / 1e6;
+}
+
+// Publisher für --mqtt (eigener Client, eigener Netzwerk-Thread)
+struct Publisher {
+    struct mosquitto* mosq = nullptr;
+
+    bool open(const std::string& host, int port)
+    {
+        mosq = mosquitto_new(nullptr, true, nullptr);
+        if (!mosq) {
+            std::cerr << "[FMreplay] mosquitto_new() failed\n";
+            return false;
+        }
+        int rc = mosquitto_connect(mosq, host.c_str(), port, 60);
+        if (rc != MOSQ_ERR_SUCCESS) {
+            std::cerr << "[FMreplay] connect " << host << ":" << port << " failed: "
+                      << mosquitto_strerror(rc) << "\n";
+            return false;
+        }
+        return mosquitto_loop_start(mosq) == MOSQ_ERR_SUCCESS;
+    }
+
+    void publish(const MqttCapture::Record& r)
+    {
+        int rc = mosquitto_publish(mosq, nullptr, r.topic.c_str(),
+                                   static_cast<int>(r.payload.size()),
+                                   r.payload.data(), 0, false);
+        if (rc != MOSQ_ERR_SUCCESS) {
+            std::cerr << "[FMreplay] publish failed: " << mosquitto_strerror(rc) << "\n";
+        }
+    }
+
+    void close()
+    {
+        if (!mosq) return;
+        mosquitto_disconnect(mosq);
+        mosquitto_loop_stop(mosq, true);
+        mosquitto_destroy(mosq);
+        mosq = nullptr;
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    int argi = 1;
+    std::string capturePath;
+    if (argv[1][0] != '-') {
+        capturePath = argv[argi++];
+    }
+
+    double        speed = 1.0;   // 0 = so schnell wie möglich
+    std::uint64_t seedPairs = 0;
+    unsigned      seedDays  = 29;
+    bool          scan = false;
+    unsigned      benchThreads = 0;
+    std::string mqttHost;
+    int         mqttPort = 1883;
+
+    ParserSettings::load();
+    ParserSettings::dbName = "fmbench";
+    ParserSettings::captureFile.clear();   // beim Replay nicht erneut mitschneiden
+    ParserSettings::spoolFile.clear();     // nicht den Spool des laufenden FMparser benutzen
+
+    for (int i = argi; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--speed" && i + 1 < argc) {
+            std::string v = argv[++i];
+            speed = (v == "max") ? 0.0 : std::atof(v.c_str());
+            if (v != "max" && speed <= 0.0) {
+                usage();
+                return EXIT_FAILURE;
+            }
+        } else if (a == "--db" && i + 1 < argc) {
+            ParserSettings::dbName = argv[++i];
+        } else if (a == "--mqtt" && i + 1 < argc) {
+            mqttHost = argv[++i];
+            auto colon = mqttHost.rfind(':');
+            if (colon != std::string::npos) {
+                mqttPort = std::atoi(mqttHost.c_str() + colon + 1);
+                mqttHost.resize(colon);
+            }
+        } else if (a == "--seed" && i + 1 < argc) {
+            seedPairs = std::strtoull(argv[++i], nullptr, 10);
+        } else if (a == "--seed-days" && i + 1 < argc) {
+            seedDays = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            if (seedDays < 1 || seedDays > 366) {
+                usage();
+                return EXIT_FAILURE;
+            }
+        } else if (a == "--scan") {
+            scan = true;
+        } else if (a == "--scan-bench" && i + 1 < argc) {
+            benchThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            if (benchThreads < 1 || benchThreads > 64) {
+                usage();
+                return EXIT_FAILURE;
+            }
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (capturePath.empty() && seedPairs == 0 && !scan && benchThreads == 0) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    // wie FMparser: Ländercodes beim Vergeben der Callsign-IDs
+    if (!ParserSettings::countryPrefixFile.empty()) {
+        CountryPrefixes::load(ParserSettings::countryPrefixFile);
+    }
+
+    if (seedPairs > 0 || scan || benchThreads > 0) {
+        FMDatabase db;
+        if (!db.available()) {
+            std::cerr << "[FMreplay] database " << ParserSettings::dbName << " not available\n";
+            return EXIT_FAILURE;
+        }
+        if (seedPairs > 0 && !seedHeard(db, seedPairs, seedDays)) {
+            return EXIT_FAILURE;
+        }
+        if (scan) {
+            QsoAggregator agg;
+            std::uint64_t rows = 0;
+            if (!db.scanQsoAggregates(agg, &rows)) {
+                return EXIT_FAILURE;
+            }
+            std::printf("[FMreplay] scan: %llu rows, peak RSS %ld kB\n",
+                        static_cast<unsigned long long>(rows), FMDatabase::peakRssKb());
+        }
+        if (benchThreads > 0 && !scanBench(db, benchThreads)) {
+            return EXIT_FAILURE;
+        }
+        if (capturePath.empty()) {
+            return EXIT_SUCCESS;
+        }
+    }
+
+    std::vector<MqttCapture::Record> records;
+    if (!MqttCapture::readAll(capturePath, records)) {
+        return EXIT_FAILURE;
+    }
+    if (records.empty()) {
+        std::cerr << "[FMreplay] " << capturePath << " contains no messages\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "[FMreplay] " << records.size() << " messages, db " << ParserSettings::dbName
+              << ", speed " << (speed > 0.0 ? std::to_string(speed) + "x" : "max")
+              << (mqttHost.empty() ? ", direct" : ", via mqtt " + mqttHost) << "\n";
+
+    const bool viaMqtt = !mqttHost.empty();
+    if (viaMqtt) {
+        ParserSettings::mqttHost = mqttHost;
+        ParserSettings::mqttPort = mqttPort;
+    }
+
+    // eigene Verbindung nur für die Status-Zähler
+    FMDatabase probe;
+    if (!probe.available()) {
+        std::cerr << "[FMreplay] database " << ParserSettings::dbName << " not available\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!MqttListener::init()) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(records.size());
+    MqttListener::setLatencySink(&latencies);
+
+    Publisher pub;
+    if (viaMqtt) {
+        MqttListener::start();
+
+        // warten bis verbunden, dann kurz für die Subscriptions
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (!MqttListener::isConnected() && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (!MqttListener::isConnected()) {
+            std::cerr << "[FMreplay] no connection to " << mqttHost << "\n";
+            MqttListener::stop();
+            return EXIT_FAILURE;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        if (!pub.open(mqttHost, mqttPort)) {
+            MqttListener::stop();
+            return EXIT_FAILURE;
+        }
+    } else {
+        MqttListener::startOffline();
+    }
+
+    std::uint64_t questionsBefore = 0;
+    bool haveQuestions = probe.globalStatus("Questions", questionsBefore);
+
+    const std::size_t   queueLimit = MqttListener::queueCapacity() - 1;
+    const std::uint64_t firstNs    = records.front().wallNs;
+    const auto          t0         = Clock::now();
+
+    for (const auto& r : records) {
+        if (speed > 0.0) {
+            // Abstände aus dem Mitschnitt, skaliert
+            std::uint64_t offs = r.wallNs > firstNs ? r.wallNs - firstNs : 0;
+            auto due = t0 + std::chrono::nanoseconds(
+                                static_cast<std::int64_t>(static_cast<double>(offs) / speed));
+            std::this_thread::sleep_until(due);
+        } else {
+            // max: nicht schneller als der Writer, sonst misst man nur Drops
+            while (MqttListener::queueDepth() >= queueLimit) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+
+        if (viaMqtt) {
+            pub.publish(r);
+        } else {
+            MqttListener::handleMessage(r.topic, r.payload);
+        }
+    }
+
+    if (viaMqtt) {
+        // alles angekommen? (QoS 0: bei Verlust nach 5 s ohne Fortschritt aufgeben)
+        std::uint64_t last = 0;
+        auto lastProgress = Clock::now();
+        while (MqttListener::messagesHandled() < records.size()) {
+            std::uint64_t n = MqttListener::messagesHandled();
+            if (n != last) {
+                last = n;
+                lastProgress = Clock::now();
+            } else if (Clock::now() - lastProgress > std::chrono::seconds(5)) {
+                std::cerr << "[FMreplay] only " << n << " of " << records.size()
+                          << " messages arrived\n";
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        pub.close();
+    }
+
+    const std::uint64_t handled = MqttListener::messagesHandled();
+    const std::uint64_t drops   = MqttListener::queueDrops();
+
+    // Queue abarbeiten lassen, danach ist alles in der DB
+    MqttListener::stop();
+    const double wallSec = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::uint64_t questionsAfter = 0;
+    haveQuestions = haveQuestions && probe.globalStatus("Questions", questionsAfter);
+
+    const std::size_t events = latencies.size();
+
+    std::printf("[FMreplay] messages:  %llu handled, %zu events written, %llu dropped\n",
+                static_cast<unsigned long long>(handled), events,
+                static_cast<unsigned long long>(drops));
+    std::printf("[FMreplay] wall:      %.3f s, %.1f events/s\n",
+                wallSec, wallSec > 0.0 ? static_cast<double>(events) / wallSec : 0.0);
+    std::printf("[FMreplay] latency:   p50 %.3f ms, p99 %.3f ms (receive -> committed)\n",
+                percentileMs(latencies, 0.50), percentileMs(latencies, 0.99));
+    if (haveQuestions && events > 0) {
+        // die zweite SHOW-Abfrage selbst zählt mit
+        std::uint64_t q = questionsAfter - questionsBefore;
+        q = q > 0 ? q - 1 : 0;
+        std::printf("[FMreplay] db:        %llu queries, %.3f queries/event\n",
+                    static_cast<unsigned long long>(q),
+                    static_cast<double>(q) / static_cast<double>(events));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,489 @@
+// http_server.cpp
+#include "http_server.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+std::string HttpServer::Request::param(const std::string& key, const std::string& def) const
+{
+    auto it = query.find(key);
+    return it == query.end() ? def : it->second;
+}
+
+HttpServer::HttpServer(std::string bindAddr, int port, Handler handler)
+    : bindAddr_(std::move(bindAddr)),
+      port_(port),
+      handler_(std::move(handler))
+{
+}
+
+HttpServer::~HttpServer()
+{
+    stop();
+
+    // erst hier: broadcast() aus anderen Threads darf bis zuletzt schreiben
+    if (efd_ >= 0) {
+        ::close(efd_);
+        efd_ = -1;
+    }
+}
+
+bool HttpServer::start()
+{
+    if (running_.load()) return true;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(static_cast<std::uint16_t>(port_));
+    if (inet_pton(AF_INET, bindAddr_.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "[HttpServer] invalid bind address " << bindAddr_ << "\n";
+        return false;
+    }
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "[HttpServer] socket failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    int one = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd_, 32) != 0) {
+        std::cerr << "[HttpServer] bind " << bindAddr_ << ":" << port_ << " failed: "
+                  << std::strerror(errno) << "\n";
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+
+    if (efd_ < 0) efd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (efd_ < 0) {
+        // ohne eventfd merkt run() stop() erst nach dem poll()-Timeout
+        std::cerr << "[HttpServer] eventfd failed: " << std::strerror(errno) << "\n";
+    }
+
+    running_ = true;
+    thread_ = std::thread(&HttpServer::run, this);
+    std::cout << "[HttpServer] listening on " << bindAddr_ << ":" << port_ << "\n";
+    return true;
+}
+
+void HttpServer::stop() noexcept
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    if (efd_ >= 0) {
+        std::uint64_t one = 1;
+        ssize_t n = ::write(efd_, &one, sizeof(one));
+        (void)n;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    for (auto& c : conns_) {
+        closeConnection(c);
+    }
+    conns_.clear();
+
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+    }
+}
+
+void HttpServer::broadcast(std::string chunk)
+{
+    if (streamClients_.load() == 0 || chunk.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMtx_);
+        // run() hängt nicht so weit hinterher; falls doch, lieber verwerfen als
+        // unbegrenzt sammeln. Ohne die Deltas wären die Clients veraltet -> run()
+        // schließt alle Streams, EventSource verbindet neu und bekommt einen status
+        if (overflow_) return;
+        if (pending_.size() + chunk.size() > kMaxPendingBytes) {
+            pending_.clear();
+            overflow_ = true;
+        } else {
+            pending_ += chunk;
+        }
+    }
+
+    if (efd_ >= 0) {
+        std::uint64_t one = 1;
+        ssize_t n = ::write(efd_, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+void HttpServer::run()
+{
+    std::vector<pollfd> fds;
+    nextHeartbeat_ = Clock::now() + kHeartbeat;
+
+    while (running_.load()) {
+        fds.clear();
+        fds.push_back(pollfd{efd_, POLLIN, 0});
+        fds.push_back(pollfd{listenFd_, POLLIN, 0});
+        for (const auto& c : conns_) {
+            short ev = 0;
+            if (c.stream) {
+                // POLLIN nur, um das Schließen durch den Browser zu sehen
+                ev = POLLIN;
+                if (c.outPos < c.out.size()) ev |= POLLOUT;
+            } else {
+                ev = c.out.empty() ? POLLIN : POLLOUT;
+            }
+            fds.push_back(pollfd{c.fd, ev, 0});
+        }
+
+        int rc = ::poll(fds.data(), fds.size(), 1000);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[HttpServer] poll failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        if (!running_.load()) break;
+
+        if (fds[0].revents & POLLIN) {
+            std::uint64_t n = 0;
+            ssize_t r = ::read(efd_, &n, sizeof(n));
+            (void)r;
+        }
+
+        // Verbindungen zuerst (Indizes passen nur vor acceptAll)
+        const auto now = Clock::now();
+        std::size_t keep = 0;
+        for (std::size_t i = 0; i < conns_.size(); ++i) {
+            Connection& c  = conns_[i];
+            short revents  = fds[i + 2].revents;
+            bool  open     = true;
+
+            if (revents & (POLLERR | POLLNVAL)) {
+                open = false;
+            } else {
+                if (revents & (POLLIN | POLLHUP)) {
+                    open = readFrom(c);
+                }
+                if (open && (revents & POLLOUT || (!c.stream && !c.out.empty()))) {
+                    open = writeTo(c);
+                }
+                // Anfrage beantwortet -> schließen (Streams bleiben offen)
+                if (open && !c.stream && !c.out.empty() && c.outPos >= c.out.size()) {
+                    open = false;
+                }
+                if (open && !c.stream && now >= c.deadline) {
+                    open = false;
+                }
+            }
+
+            if (!open) {
+                closeConnection(c);
+                continue;
+            }
+            if (keep != i) conns_[keep] = std::move(c);
+            ++keep;
+        }
+        conns_.resize(keep);
+
+        bool overflow = false;
+        {
+            std::lock_guard<std::mutex> lock(pendingMtx_);
+            delivering_.swap(pending_);
+            overflow  = overflow_;
+            overflow_ = false;
+        }
+        if (overflow) {
+            closeStreams();
+        }
+        if (now >= nextHeartbeat_) {
+            delivering_ += ": ping\n\n";
+            nextHeartbeat_ = now + kHeartbeat;
+        }
+        if (!delivering_.empty()) {
+            deliver(delivering_);
+            delivering_.clear();
+        }
+
+        if (fds[1].revents & POLLIN) {
+            acceptAll();
+        }
+    }
+}
+
+// an jeden Stream-Client anhängen und gleich versuchen zu senden;
+// wer den Puffer nicht leert, wird geschlossen
+void HttpServer::deliver(const std::string& chunk)
+{
+    std::size_t keep = 0;
+    for (std::size_t i = 0; i < conns_.size(); ++i) {
+        Connection& c = conns_[i];
+        bool open = true;
+
+        if (c.stream) {
+            // Gesendetes vorne abschneiden, der Puffer hält nur den Rückstand
+            if (c.outPos > 0) {
+                c.out.erase(0, c.outPos);
+                c.outPos = 0;
+            }
+            if (c.out.size() + chunk.size() > kMaxStreamBacklog) {
+                std::uint64_t n = ++evictions_;
+                std::cerr << "[HttpServer] slow stream client evicted (" << n << " total)\n";
+                open = false;
+            } else {
+                c.out += chunk;
+                open = writeTo(c);
+            }
+        }
+
+        if (!open) {
+            closeConnection(c);
+            continue;
+        }
+        if (keep != i) conns_[keep] = std::move(c);
+        ++keep;
+    }
+    conns_.resize(keep);
+}
+
+// nach verworfenen Chunks: alle Streams zu, die Clients verbinden neu
+void HttpServer::closeStreams()
+{
+    std::size_t keep   = 0;
+    std::size_t closed = 0;
+    for (std::size_t i = 0; i < conns_.size(); ++i) {
+        Connection& c = conns_[i];
+        if (c.stream) {
+            closeConnection(c);
+            ++closed;
+            continue;
+        }
+        if (keep != i) conns_[keep] = std::move(c);
+        ++keep;
+    }
+    conns_.resize(keep);
+
+    std::cerr << "[HttpServer] broadcast backlog overflow, " << closed
+              << " stream clients closed\n";
+}
+
+void HttpServer::closeConnection(Connection& c) noexcept
+{
+    if (c.stream) --streamClients_;
+    ::close(c.fd);
+    c.fd = -1;
+}
+
+void HttpServer::acceptAll()
+{
+    for (;;) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "[HttpServer] accept failed: " << std::strerror(errno) << "\n";
+            }
+            return;
+        }
+        if (conns_.size() >= kMaxConnections) {
+            ::close(fd);
+            continue;
+        }
+
+        Connection c;
+        c.fd       = fd;
+        c.deadline = Clock::now() + kIdleTimeout;
+        conns_.push_back(std::move(c));
+    }
+}
+
+bool HttpServer::readFrom(Connection& c)
+{
+    char buf[2048];
+    for (;;) {
+        ssize_t n = ::recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            if (c.stream || !c.out.empty()) continue;   // nach der Anfrage: ignorieren
+            c.in.append(buf, static_cast<std::size_t>(n));
+            if (c.in.size() > kMaxRequestBytes) return false;
+            continue;
+        }
+        if (n == 0) return false;   // Client hat geschlossen
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return false;
+    }
+
+    // nur der Kopf zählt, GET hat keinen Body
+    if (!c.stream && c.out.empty() && c.in.find("\r\n\r\n") != std::string::npos) {
+        respond(c);
+    }
+    return true;
+}
+
+bool HttpServer::writeTo(Connection& c)
+{
+    while (c.outPos < c.out.size()) {
+        ssize_t n = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.outPos += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::respond(Connection& c)
+{
+    Request  req;
+    Response res;
+
+    if (!parseRequest(c.in, req)) {
+        res.status = 400;
+        res.body   = "{\"error\":\"bad request\"}";
+    } else if (req.method != "GET") {
+        res.status = 405;
+        res.body   = "{\"error\":\"method not allowed\"}";
+    } else {
+        // vorab als Stream-Client zählen: broadcast() sammelt dann schon, während
+        // der Handler den Anfangsstand baut, und run() liefert es danach aus
+        // (ein Delta kommt so eher doppelt als gar nicht)
+        ++streamClients_;
+        try {
+            res = handler_(req);
+        } catch (const std::exception& e) {
+            std::cerr << "[HttpServer] handler failed: " << e.what() << "\n";
+            res        = Response{};
+            res.status = 500;
+            res.body   = "{\"error\":\"internal error\"}";
+        }
+        if (res.stream && streamClients_.load() > kMaxStreamClients) {
+            res        = Response{};
+            res.status = 503;
+            res.body   = "{\"error\":\"too many streams\"}";
+        }
+        if (!res.stream) --streamClients_;
+    }
+
+    c.in.clear();
+
+    if (res.stream) {
+        c.out  = "HTTP/1.1 200 OK\r\n";
+        c.out += "Content-Type: " + res.contentType + "\r\n";
+        c.out += "Cache-Control: no-store\r\n";
+        c.out += "X-Accel-Buffering: no\r\n";
+        c.out += "Connection: keep-alive\r\n\r\n";
+        c.out += res.body;
+        c.outPos = 0;
+        c.stream = true;   // schon in streamClients_ gezählt
+        return;
+    }
+
+    c.out.reserve(res.body.size() + 160);
+    c.out  = "HTTP/1.1 " + std::to_string(res.status) + " " + statusText(res.status) + "\r\n";
+    c.out += "Content-Type: " + res.contentType + "\r\n";
+    c.out += "Content-Length: " + std::to_string(res.body.size()) + "\r\n";
+    c.out += "Cache-Control: no-store\r\n";
+    c.out += "Connection: close\r\n\r\n";
+    c.out += res.body;
+    c.outPos   = 0;
+    c.deadline = Clock::now() + kIdleTimeout;
+}
+
+// "GET /pfad?a=1&b=x%20y HTTP/1.1\r\n..." -> method, path, query
+bool HttpServer::parseRequest(std::string_view head, Request& out)
+{
+    std::size_t eol = head.find("\r\n");
+    if (eol == std::string_view::npos) return false;
+    std::string_view line = head.substr(0, eol);
+
+    std::size_t sp1 = line.find(' ');
+    if (sp1 == std::string_view::npos) return false;
+    std::size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos) return false;
+
+    out.method = std::string(line.substr(0, sp1));
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    if (target.empty() || target[0] != '/') return false;
+
+    std::size_t qm = target.find('?');
+    out.path = urlDecode(target.substr(0, qm));
+    if (qm == std::string_view::npos) return true;
+
+    std::string_view qs = target.substr(qm + 1);
+    while (!qs.empty()) {
+        std::size_t amp = qs.find('&');
+        std::string_view kv = qs.substr(0, amp);
+        if (!kv.empty()) {
+            std::size_t eq = kv.find('=');
+            std::string key = urlDecode(kv.substr(0, eq));
+            std::string val = eq == std::string_view::npos ? std::string()
+                                                           : urlDecode(kv.substr(eq + 1));
+            // wie PHP: der letzte Wert gewinnt
+            out.query[std::move(key)] = std::move(val);
+        }
+        if (amp == std::string_view::npos) break;
+        qs.remove_prefix(amp + 1);
+    }
+    return true;
+}
+
+std::string HttpServer::urlDecode(std::string_view s)
+{
+    auto hex = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    std::string out;
+    out.reserve(s.size());
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c == '+') {
+            out += ' ';
+        } else if (c == '%' && i + 2 < s.size() &&
+                   hex(s[i + 1]) >= 0 && hex(s[i + 2]) >= 0) {
+            out += static_cast<char>(hex(s[i + 1]) * 16 + hex(s[i + 2]));
+            i += 2;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+const char* HttpServer::statusText(int status) noexcept
+{
+    switch (status) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default:  return "Unknown";
+    }
+}
@@ -0,0 +1,128 @@
+// http_server.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Minimaler HTTP/1.1-Server für die LiveApi: nur GET, eine Anfrage pro
+// Verbindung (Connection: close). Ein Thread, nicht-blockierende Sockets
+// mit poll(), ein hängender Client hält also niemanden auf und fliegt nach
+// kIdleTimeout raus. Gedacht für 127.0.0.1 hinter Apache/api.php, nicht
+// für das offene Netz (kein TLS, keine Authentifizierung).
+//
+// Streams (Server-Sent Events): Antwortet der Handler mit stream = true,
+// bleibt die Verbindung offen und bekommt alles, was broadcast() verteilt.
+// Jeder Stream-Client hat einen eigenen Puffer; wächst der über
+// kMaxStreamBacklog (Browser hängt, Netz zu langsam), fliegt er raus und
+// verbindet sich per EventSource neu. Läuft der gemeinsame Puffer über
+// kMaxPendingBytes, werden alle Streams geschlossen. Alle kHeartbeat ein Kommentar, damit
+// Proxies die Verbindung nicht schließen und tote Clients auffallen.
+class HttpServer {
+public:
+    struct Request {
+        std::string method;
+        std::string path;                                     // ohne Query-String
+        std::unordered_map<std::string, std::string> query;   // URL-dekodiert
+
+        // Query-Parameter oder def, wenn nicht vorhanden
+        std::string param(const std::string& key, const std::string& def = std::string()) const;
+        bool        has(const std::string& key) const { return query.count(key) != 0; }
+    };
+
+    struct Response {
+        int         status = 200;
+        std::string contentType = "application/json; charset=utf-8";
+        std::string body;
+        bool        stream = false;   // body ist der Anfang, danach broadcast()
+    };
+
+    using Handler = std::function<Response(const Request&)>;
+
+    HttpServer(std::string bindAddr, int port, Handler handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // false -> Socket/bind/listen fehlgeschlagen (geloggt)
+    bool start();
+    void stop() noexcept;
+
+    // an alle Stream-Clients (thread-safe, blockiert nicht auf Sockets)
+    void broadcast(std::string chunk);
+
+    // nichts formatieren, wenn keiner zuhört; ein neuer Stream zählt schon,
+    // bevor der Handler seinen Anfangsstand baut (Aufrufer: erst Zustand
+    // ändern, dann fragen -> kein Delta geht zwischen Stand und Anmeldung verloren)
+    bool hasStreamClients() const noexcept { return streamClients_.load() > 0; }
+
+    // für Tests/Logs: tatsächlicher Port (bei port 0 vom System vergeben)
+    int port() const noexcept { return port_; }
+
+    std::uint64_t evictions() const noexcept { return evictions_.load(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t kMaxConnections = 64;
+    static constexpr std::size_t kMaxRequestBytes = 8 * 1024;
+    static constexpr std::chrono::seconds kIdleTimeout{5};
+
+    static constexpr std::size_t kMaxStreamClients = 48;   // Rest bleibt für Abfragen
+    static constexpr std::size_t kMaxStreamBacklog = 64 * 1024;
+    static constexpr std::size_t kMaxPendingBytes  = 1024 * 1024;
+    static constexpr std::chrono::seconds kHeartbeat{15};
+
+    struct Connection {
+        int               fd = -1;
+        std::string       in;
+        std::string       out;
+        std::size_t       outPos = 0;
+        Clock::time_point deadline;   // nur ohne stream
+        bool              stream = false;
+    };
+
+    void run();
+    void acceptAll();
+    bool readFrom(Connection& c);    // false -> schließen
+    bool writeTo(Connection& c);     // false -> Fehler, schließen
+    void respond(Connection& c);
+    void closeConnection(Connection& c) noexcept;
+    void deliver(const std::string& chunk);
+    void closeStreams();
+
+    static bool        parseRequest(std::string_view head, Request& out);
+    static std::string urlDecode(std::string_view s);
+    static const char* statusText(int status) noexcept;
+
+    std::string bindAddr_;
+    int         port_;
+    Handler     handler_;
+
+    int listenFd_ = -1;
+    int efd_      = -1;   // weckt poll() bei stop()
+
+    std::vector<Connection> conns_;
+
+    std::mutex  pendingMtx_;
+    std::string pending_;     // unter pendingMtx_, von broadcast()
+    bool        overflow_ = false;   // unter pendingMtx_: Chunks verworfen -> Streams schließen
+    std::string delivering_;  // nur run()
+
+    Clock::time_point nextHeartbeat_{};
+
+    std::atomic<std::size_t>   streamClients_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+
+    std::thread       thread_;
+    std::atomic<bool> running_{false};
+};
@@ -0,0 +1,135 @@
+// last_heard.cpp
+#include "last_heard.h"
+
+#include <algorithm>
+#include <ctime>
+#include <iterator>
+
+LastHeard::LastHeard()
+    : firstSeq_((static_cast<std::uint64_t>(std::time(nullptr)) << 20) + 1),
+      seq_(firstSeq_ - 1)
+{
+}
+
+void LastHeard::insertSorted(std::deque<LastHeardQso>& d, const LastHeardQso& q)
+{
+    // fast immer das neueste -> hinten anhängen; gleiche Zeit: nach den vorhandenen
+    auto pos = d.end();
+    while (pos != d.begin() && std::prev(pos)->endTime > q.endTime) --pos;
+
+    if (d.size() >= kRows) {
+        if (pos == d.begin()) return;   // älter als alles in der Liste
+        d.insert(pos, q);
+        d.pop_front();
+        return;
+    }
+    d.insert(pos, q);
+}
+
+void LastHeard::addLocked(const LastHeardQso& q)
+{
+    LastHeardQso row(q);
+    row.seq = ++seq_;
+    insertSorted(all_, row);
+    insertSorted(perTg_[row.tg], row);
+}
+
+void LastHeard::add(const LastHeardQso& q)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    addLocked(q);
+}
+
+void LastHeard::add(const std::vector<LastHeardQso>& qsos)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const auto& q : qsos) {
+        addLocked(q);
+    }
+}
+
+void LastHeard::setLocation(const std::string& call, const std::string& location)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    locations_[call] = location;
+}
+
+void LastHeard::collect(const std::vector<int>* tgs, std::vector<LastHeardQso>& out) const
+{
+    out.clear();
+    if (!tgs) {
+        out.assign(all_.rbegin(), all_.rend());
+        return;
+    }
+
+    // doppelte TGs in der Liste zählen einmal (wie tg IN (...))
+    std::vector<int> uniq(*tgs);
+    std::sort(uniq.begin(), uniq.end());
+    uniq.erase(std::unique(uniq.begin(), uniq.end()), uniq.end());
+
+    for (int tg : uniq) {
+        auto it = perTg_.find(tg);
+        if (it == perTg_.end()) continue;
+        out.insert(out.end(), it->second.begin(), it->second.end());
+    }
+
+    std::stable_sort(out.begin(), out.end(), [](const LastHeardQso& a, const LastHeardQso& b) {
+        return a.endTime > b.endTime;
+    });
+    if (out.size() > kRows) out.resize(kRows);
+}
+
+std::vector<LastHeardQso> LastHeard::latest() const
+{
+    std::vector<LastHeardQso> out;
+    std::lock_guard<std::mutex> lock(mtx_);
+    collect(nullptr, out);
+    return out;
+}
+
+std::vector<LastHeardQso> LastHeard::latestForTgs(const std::vector<int>& tgs) const
+{
+    std::vector<LastHeardQso> out;
+    std::lock_guard<std::mutex> lock(mtx_);
+    collect(&tgs, out);
+    return out;
+}
+
+bool LastHeard::newerThan(std::uint64_t since, const std::vector<int>* tgs,
+                          std::vector<LastHeardQso>& out, std::uint64_t& seq) const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    collect(tgs, out);
+    seq = seq_;
+
+    // aus einem früheren Lauf (oder 0) bzw. aus der Zukunft -> alles
+    if (since < firstSeq_ - 1 || since > seq_) return false;
+
+    std::vector<LastHeardQso> fresh;
+    for (const auto& q : out) {
+        if (q.seq > since) fresh.push_back(q);
+    }
+
+    // so viel Neues, dass Zeilen dazwischen herausgefallen sein können
+    if (fresh.size() >= kRows) return false;
+
+    out.swap(fresh);
+    return true;
+}
+
+bool LastHeard::location(const std::string& call, std::string& out) const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = locations_.find(call);
+    if (it == locations_.end()) return false;
+    out = it->second;
+    return true;
+}
+
+void LastHeard::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    all_.clear();
+    perTg_.clear();
+    locations_.clear();
+}
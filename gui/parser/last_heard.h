@@ -0,0 +1,77 @@
+// last_heard.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// abgeschlossenes QSO wie in fmqso (Zeile der Last-Heard-Liste)
+struct LastHeardQso {
+    std::string   callsign;
+    int           tg = 0;
+    std::string   server;
+    std::string   endTime;            // "YYYY-MM-DD HH:MM:SS" des stop-Events
+    std::uint64_t durationSec = 0;
+    bool          hasDuration = false;   // false -> duration_s NULL
+    std::uint64_t seq = 0;               // vergibt LastHeard::add()
+};
+
+// Die letzten QSOs aus fmqso und die Standorte aus nodes im Speicher, damit
+// die Last-Heard-Liste (api.php?q=fmlastheard) ohne MySQL beantwortet werden
+// kann (LiveApi). Je kRows Einträge gesamt und pro TG, das genügt für jeden
+// Filter der GUI (alle / eine TG / Monitor-TGs, jeweils LIMIT 50).
+// Gefüttert vom DB-Writer nach dem COMMIT, gelesen vom HTTP-Thread -> intern gelockt.
+//
+// Jede neue Zeile bekommt eine fortlaufende Nummer (seq). Clients merken sich
+// die letzte und fragen nur noch nach Neuerem (fmlastheard&since=...).
+// Die Zählung beginnt bei Startzeit << 20, eine seq aus einem früheren Lauf
+// ist damit immer kleiner als alles aus diesem und wird erkannt.
+class LastHeard {
+public:
+    static constexpr std::size_t kRows = 50;
+
+    LastHeard();
+
+    // nach end_time einsortiert, ältere fallen hinten heraus
+    void add(const LastHeardQso& q);
+    void add(const std::vector<LastHeardQso>& qsos);
+
+    // nodes.location; nicht gesetzt -> NULL in der Antwort
+    void setLocation(const std::string& call, const std::string& location);
+
+    // neueste zuerst, höchstens kRows
+    std::vector<LastHeardQso> latest() const;
+    std::vector<LastHeardQso> latestForTgs(const std::vector<int>& tgs) const;
+
+    // Zeilen mit seq > since, neueste zuerst; tgs == nullptr -> alle TGs.
+    // seq bekommt den aktuellen Stand. false -> since nicht verwendbar
+    // (früherer Lauf, unbekannt oder kRows und mehr dahinter), out ist dann
+    // die vollständige Liste wie latest()/latestForTgs()
+    bool newerThan(std::uint64_t since, const std::vector<int>* tgs,
+                   std::vector<LastHeardQso>& out, std::uint64_t& seq) const;
+
+    // false -> kein Node-Eintrag (oder location NULL)
+    bool location(const std::string& call, std::string& out) const;
+
+    void clear();
+
+private:
+    static void insertSorted(std::deque<LastHeardQso>& d, const LastHeardQso& q);
+
+    // ohne Lock: neueste zuerst, höchstens kRows
+    void collect(const std::vector<int>* tgs, std::vector<LastHeardQso>& out) const;
+    void addLocked(const LastHeardQso& q);
+
+    mutable std::mutex mtx_;
+
+    std::deque<LastHeardQso>                          all_;     // aufsteigend nach endTime
+    std::unordered_map<int, std::deque<LastHeardQso>> perTg_;   // dito, je TG
+    std::unordered_map<std::string, std::string>      locations_;
+
+    std::uint64_t firstSeq_;   // erste seq dieses Laufs
+    std::uint64_t seq_;        // zuletzt vergeben
+};
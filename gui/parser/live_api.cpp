@@ -0,0 +1,295 @@
+// live_api.cpp
+#include "live_api.h"
+
+#include "MqttListener.h"
+#include "active_talkers.h"
+#include "callsign_dict.h"
+#include "db_writer.h"
+#include "fmdatabase.h"
+#include "last_heard.h"
+#include "stats_json.h"
+#include "stats_worker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <nlohmann/json.hpp>
+
+using nlohmann::ordered_json;
+
+namespace {
+
+// json_encode(..., JSON_UNESCAPED_UNICODE); kaputtes UTF-8 aus MQTT ersetzen statt werfen
+std::string dump(const ordered_json& j)
+{
+    return j.dump(-1, ' ', false, ordered_json::error_handler_t::replace);
+}
+
+// (int)$_GET['tg'] in PHP: führende Zahl, sonst 0
+int toInt(const std::string& s)
+{
+    return static_cast<int>(std::strtol(s.c_str(), nullptr, 10));
+}
+
+ordered_json locationOf(const LastHeard& lh, const std::string& call)
+{
+    std::string loc;
+    if (lh.location(call, loc)) return loc;
+    return nullptr;
+}
+
+// beim Vergeben der Callsign-ID aufgelöst (CountryPrefixes), null ohne Treffer
+ordered_json countryOf(const std::string& call)
+{
+    std::string cc = CallsignDict::countryOf(call);
+    if (cc.empty()) return nullptr;
+    return cc;
+}
+
+// Zeilen wie api.php?q=fmstatus (neueste zuerst); null -> Writer nicht bereit
+ordered_json statusRows()
+{
+    const ActiveTalkers* talkers = MqttListener::activeTalkers();
+    const LastHeard*     lh      = MqttListener::lastHeard();
+    if (!talkers || !lh) return nullptr;
+
+    std::vector<ActiveTalker> rows = talkers->snapshot();
+    std::stable_sort(rows.begin(), rows.end(), [](const ActiveTalker& a, const ActiveTalker& b) {
+        return a.eventTime > b.eventTime;
+    });
+
+    ordered_json out = ordered_json::array();
+    for (const auto& t : rows) {
+        out.push_back({
+            {"callsign",   t.callsign},
+            {"tg",         t.tg},
+            {"server",     t.server},
+            {"event_time", t.eventTime},
+            {"location",   locationOf(*lh, t.callsign)},
+            {"country_code", countryOf(t.callsign)},
+        });
+    }
+    return out;
+}
+
+std::string sseFrame(const char* event, const ordered_json& data)
+{
+    // dump() ist einzeilig -> genau eine data:-Zeile
+    std::string out = "event: ";
+    out += event;
+    out += "\ndata: ";
+    out += dump(data);
+    out += "\n\n";
+    return out;
+}
+
+} // namespace
+
+LiveApi::LiveApi(const StatsWorker& stats)
+    : stats_(stats)
+{
+}
+
+HttpServer::Response LiveApi::handle(const HttpServer::Request& req) const
+{
+    if (req.path == "/events") {
+        return events();
+    }
+    if (req.path != "/api") {
+        return json(404, "{\"error\":\"not found\"}");
+    }
+
+    const std::string q = req.param("q", "status");
+
+    if (q == "fmstatus")                 return fmStatus();
+    if (q == "fmlastheard")              return fmLastHeard(req);
+    if (q == "fm_callsignTop10Count")    return topCalls(req, false);
+    if (q == "fm_callsignTop10Duration") return topCalls(req, true);
+    if (q == "fm_hallOfFameWeek")        return hallOfFame(req);
+    if (q == "fm_topTalkgroups")         return topTalkgroups(req);
+    if (q == "fmheatmap")                return heatmap();
+    if (q == "parser_status")            return parserStatus();
+
+    return json(400, "{\"error\":\"bad query\"}");
+}
+
+HttpServer::Response LiveApi::events() const
+{
+    ordered_json rows = statusRows();
+    if (rows.is_null()) return unavailable();
+
+    HttpServer::Response res;
+    res.contentType = "text/event-stream; charset=utf-8";
+    res.stream      = true;
+    // Reconnect nach 3 s (EventSource), dann kommt wieder ein vollständiger status
+    res.body        = "retry: 3000\n\n" + sseFrame("status", rows);
+    return res;
+}
+
+HttpServer::Response LiveApi::fmStatus() const
+{
+    ordered_json rows = statusRows();
+    if (rows.is_null()) return unavailable();
+    return json(200, dump(rows));
+}
+
+std::string LiveApi::formatChange(const LiveChange& c) const
+{
+    switch (c.kind) {
+    case LiveChange::Kind::Start: {
+        const LastHeard* lh = MqttListener::lastHeard();
+        return sseFrame("talk", {
+            {"talk",       "start"},
+            {"callsign",   c.callsign},
+            {"tg",         c.tg},
+            {"server",     c.server},
+            {"event_time", c.eventTime},
+            {"location",   lh ? locationOf(*lh, c.callsign) : ordered_json(nullptr)},
+            {"country_code", countryOf(c.callsign)},
+        });
+    }
+    case LiveChange::Kind::Stop:
+    case LiveChange::Kind::Timeout:
+        return sseFrame("talk", {{"talk", "stop"}, {"callsign", c.callsign}});
+    case LiveChange::Kind::Node:
+        return sseFrame("node", {{"callsign", c.callsign}, {"location", c.location}});
+    }
+    return std::string();
+}
+
+HttpServer::Response LiveApi::fmLastHeard(const HttpServer::Request& req) const
+{
+    const LastHeard* lh = MqttListener::lastHeard();
+    if (!lh) return unavailable();
+
+    // Filter wie api.php: ungültige Angaben -> keine Einschränkung
+    const std::string mode = req.param("mode", "all");
+    std::vector<int> tgs;
+    if (mode == "local" && toInt(req.param("tg")) > 0) {
+        tgs.push_back(toInt(req.param("tg")));
+    } else if (mode == "monitored") {
+        tgs = parseTgList(req.param("tgs"));
+    }
+    const std::vector<int>* filter = tgs.empty() ? nullptr : &tgs;
+
+    // since=<seq>: nur Neues, als {seq, full, rows}; ohne since wie api.php
+    std::vector<LastHeardQso> rows;
+    std::uint64_t seq   = 0;
+    bool          delta = req.has("since");
+    bool          full  = true;
+    if (delta) {
+        std::uint64_t since = std::strtoull(req.param("since").c_str(), nullptr, 10);
+        full = !lh->newerThan(since, filter, rows, seq);
+    } else {
+        rows = filter ? lh->latestForTgs(tgs) : lh->latest();
+    }
+
+    ordered_json out = ordered_json::array();
+    for (const auto& r : rows) {
+        out.push_back({
+            {"callsign",   r.callsign},
+            {"tg",         r.tg},
+            {"server",     r.server},
+            {"talk",       "stop"},
+            {"event_time", r.endTime},
+            {"duration_s", r.hasDuration ? ordered_json(r.durationSec) : ordered_json(nullptr)},
+            {"location",   locationOf(*lh, r.callsign)},
+            {"country_code", countryOf(r.callsign)},
+        });
+    }
+
+    if (!delta) return json(200, dump(out));
+    return json(200, dump({{"seq", seq}, {"full", full}, {"rows", std::move(out)}}));
+}
+
+HttpServer::Response LiveApi::topCalls(const HttpServer::Request& req, bool byDuration) const
+{
+    auto snap = stats_.snapshot();
+    if (!snap) return unavailable();
+
+    const FMStatsWindow* w = StatsJson::findWindow(snap->windows, req.param("window", "30d"));
+    if (!w) return json(200, StatsJson::emptyList());
+
+    // Scope wie fm_stats_scope() in api.php
+    const std::string mode = req.param("mode", "all");
+    const int         tg   = toInt(req.param("tg"));
+    if (mode == "local" && tg > 0) {
+        const FMTgCallLists* l = StatsJson::findTg(*w, tg);
+        if (!l) return json(200, StatsJson::emptyList());   // keine Liste für diese TG
+        return json(200, byDuration ? StatsJson::callsByDuration(l->topCallsByDuration)
+                                    : StatsJson::callsByCount(l->topCallsByCount));
+    }
+    if (mode == "monitored") {
+        return json(200, byDuration ? StatsJson::callsByDuration(w->monitored.topCallsByDuration)
+                                    : StatsJson::callsByCount(w->monitored.topCallsByCount));
+    }
+    return json(200, byDuration ? StatsJson::callsByDuration(w->topCallsByDuration)
+                                : StatsJson::callsByCount(w->topCallsByCount));
+}
+
+HttpServer::Response LiveApi::hallOfFame(const HttpServer::Request& req) const
+{
+    auto snap = stats_.snapshot();
+    if (!snap) return unavailable();
+
+    const FMStatsWindow* w = StatsJson::findWindow(snap->windows, req.param("window", "30d"));
+    return json(200, w ? StatsJson::hallOfFame(*w) : StatsJson::emptyList());
+}
+
+HttpServer::Response LiveApi::topTalkgroups(const HttpServer::Request& req) const
+{
+    auto snap = stats_.snapshot();
+    if (!snap) return unavailable();
+
+    const FMStatsWindow* w = StatsJson::findWindow(snap->windows, req.param("window", "30d"));
+    return json(200, w ? StatsJson::topTalkgroups(*w) : StatsJson::emptyList());
+}
+
+HttpServer::Response LiveApi::heatmap() const
+{
+    auto snap = stats_.snapshot();
+    if (!snap) return unavailable();
+
+    return json(200, StatsJson::heatmap(snap->heatmapWeek));
+}
+
+// Monitoring des Statistik-Threads; last_run_at als Unix-Zeit, null vor dem ersten Lauf
+HttpServer::Response LiveApi::parserStatus() const
+{
+    const std::time_t at = stats_.lastRunAt();
+    return json(200, dump({
+        {"last_run_ms", at ? ordered_json(stats_.lastRunMs()) : ordered_json(nullptr)},
+        {"last_run_at", at ? ordered_json(static_cast<std::int64_t>(at)) : ordered_json(nullptr)},
+        {"ok",          stats_.lastRunOk()},
+        {"runs",        stats_.runs()},
+        {"failures",    stats_.failures()},
+        {"skipped",     stats_.skipped()},
+    }));
+}
+
+// "1, 2,x,3" -> {1, 2, 3}; wie api.php nur Werte > 0
+std::vector<int> LiveApi::parseTgList(const std::string& csv)
+{
+    std::vector<int> out;
+    std::size_t pos = 0;
+    while (pos <= csv.size()) {
+        std::size_t comma = csv.find(',', pos);
+        if (comma == std::string::npos) comma = csv.size();
+        int tg = toInt(csv.substr(pos, comma - pos));
+        if (tg > 0) out.push_back(tg);
+        pos = comma + 1;
+    }
+    return out;
+}
+
+HttpServer::Response LiveApi::json(int status, std::string body)
+{
+    HttpServer::Response res;
+    res.status = status;
+    res.body   = std::move(body);
+    return res;
+}
+
+HttpServer::Response LiveApi::unavailable()
+{
+    return json(503, "{\"error\":\"not ready\"}");
+}
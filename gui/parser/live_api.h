@@ -0,0 +1,55 @@
+// live_api.h
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "http_server.h"
+
+class StatsWorker;
+struct LiveChange;
+
+// Beantwortet die Live-Abfragen von api.php aus dem Speicher von FMparser
+// statt aus MySQL: GET /api?q=... mit denselben Parametern und derselben
+// JSON-Form wie api.php (country_code aus CallsignDict, null ohne Treffer).
+//   fmstatus, fmlastheard                  <- DB-Writer (ActiveTalkers, LastHeard)
+//   fmlastheard&since=<seq>                -> {seq, full, rows}: nur Zeilen nach
+//                                             seq (full = false) oder alles (true)
+//   fm_callsignTop10Count/-Duration,
+//   fm_hallOfFameWeek, fm_topTalkgroups,
+//   fmheatmap                              <- letzter Statistik-Lauf (StatsWorker)
+//   parser_status                          -> {last_run_ms, last_run_at, ok, runs,
+//                                             failures, skipped} des StatsWorker
+// 503, solange die Quelle noch nicht bereit ist -> api.php fällt auf MySQL zurück.
+// Läuft im Thread des HttpServer.
+//
+// GET /events: Server-Sent Events für die Liste der aktiven Stationen.
+// Zuerst "status" (wie fmstatus), danach Deltas aus dem DB-Writer:
+//   event: talk  data: {"talk":"start",callsign,tg,server,event_time,location,country_code}
+//   event: talk  data: {"talk":"stop",callsign}       (auch bei Timeout)
+//   event: node  data: {callsign,location}
+class LiveApi {
+public:
+    explicit LiveApi(const StatsWorker& stats);
+
+    HttpServer::Response handle(const HttpServer::Request& req) const;
+
+    // SSE-Frame für HttpServer::broadcast(); im Writer-Thread aufgerufen
+    std::string formatChange(const LiveChange& c) const;
+
+private:
+    HttpServer::Response events() const;
+    HttpServer::Response fmStatus() const;
+    HttpServer::Response fmLastHeard(const HttpServer::Request& req) const;
+    HttpServer::Response topCalls(const HttpServer::Request& req, bool byDuration) const;
+    HttpServer::Response hallOfFame(const HttpServer::Request& req) const;
+    HttpServer::Response topTalkgroups(const HttpServer::Request& req) const;
+    HttpServer::Response heatmap() const;
+    HttpServer::Response parserStatus() const;
+
+    static std::vector<int>     parseTgList(const std::string& csv);
+    static HttpServer::Response json(int status, std::string body);
+    static HttpServer::Response unavailable();
+
+    const StatsWorker& stats_;
+};
@@ -1,39 +1,94 @@
-#include <thread>
 #include <chrono>
 #include <csignal>
-#include <atomic>
+#include <iostream>
 #include "MqttListener.h"
+#include "country_prefixes.h"
 #include "handleConfig.h"
+#include "http_server.h"
+#include "live_api.h"
 #include "node_info_writer.h"
 #include "fmdatabase.h"
+#include "parser_settings.h"
+#include "retention_job.h"
+#include "scheduler.h"
+#include "stats_worker.h"
 
-static std::atomic<bool> g_running{true};
+static Scheduler* g_scheduler = nullptr;
 
 void sigHandler(int)
 {
-    g_running = false;
+    // async-signal-safe, beendet scheduler.run() sofort
+    if (g_scheduler) g_scheduler->stop();
 }
 
 int main(){
 
+    using namespace std::chrono;
+
+    Scheduler scheduler;
+    g_scheduler = &scheduler;
+
+    // optionale Einstellungen, fehlt die Datei gelten Defaults
+    ParserSettings::load();
+
+    // Ländercodes je Callsign, vor dem ersten CallsignDict::intern()
+    if (!ParserSettings::countryPrefixFile.empty()) {
+        CountryPrefixes::load(ParserSettings::countryPrefixFile);
+    }
+
     // Starte FM Funknetz Abfragen als Thread
     MqttListener::init();
     std::signal(SIGINT,  sigHandler);
     std::signal(SIGTERM, sigHandler);
+
+    // Statistik im eigenen Thread, blockiert weder node_info noch SIGTERM
+    StatsWorker stats(MqttListener::qsoAggregator());
+
+    // LiveApi für api.php (Live-Status, Last-Heard, Top-Listen aus dem Speicher)
+    // und SSE-Stream /events; Deltas kommen direkt aus dem DB-Writer, daher
+    // vor MqttListener::start() verbinden
+    LiveApi    liveApi(stats);
+    HttpServer http(ParserSettings::httpBind, ParserSettings::httpPort,
+                    [&](const HttpServer::Request& req) { return liveApi.handle(req); });
+    if (ParserSettings::httpPort > 0) {
+        if (http.start()) {
+            MqttListener::setChangeSink([&](const LiveChange& c) {
+                if (http.hasStreamClients()) http.broadcast(liveApi.formatChange(c));
+            });
+        } else {
+            std::cerr << "[main] LiveApi not available, api.php uses MySQL\n";
+        }
+    }
+
     MqttListener::start();
 
     handleConfig cfg;
     cfg.run();
 
-    FMDatabase g_db;
+    stats.start();
 
     NodeInfoWriter nodeInfoWriter("/etc/svxlink/node_info.json");
 
-    while(g_running) {
-        nodeInfoWriter.tick();
-        g_db.statistics();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
+    RetentionJob retention(ParserSettings::retentionDays,
+                           ParserSettings::retentionIntervalMin,
+                           ParserSettings::retentionChunkRows,
+                           ParserSettings::retentionPauseMs);
+
+    scheduler.every("node_info", seconds(2), [&] { nodeInfoWriter.tick(); });
+    scheduler.every("statistics", minutes(10), [&] { stats.trigger(); });
+    scheduler.dynamic("retention", milliseconds(0), [&] { return retention.tick(); });
+
+    // läuft bis SIGINT/SIGTERM
+    scheduler.run();
+
+    // vor StatsWorker und DB-Writer: die LiveApi liest aus beiden.
+    // Bis MqttListener::stop() kann der Writer noch broadcast() aufrufen,
+    // nach stop() ist das ein No-op (keine Stream-Clients mehr)
+    http.stop();
+
+    // vor dem DB-Writer: der Lauf liest dessen Aggregate
+    stats.stop();
     MqttListener::stop();
+    g_scheduler = nullptr;
     return 0;
 }
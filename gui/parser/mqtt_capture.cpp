@@ -0,0 +1,142 @@
+// mqtt_capture.cpp
+#include "mqtt_capture.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+std::uint64_t MqttCapture::wallNs() noexcept
+{
+    using namespace std::chrono;
+    return static_cast<std::uint64_t>(
+        duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+bool MqttCapture::open(const std::string& path) noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    if (s_file) {
+        std::cerr << "[MqttCapture] already open\n";
+        return false;
+    }
+
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    if (!f) {
+        std::cerr << "[MqttCapture] cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // neue Datei -> Magic schreiben
+    std::fseek(f, 0, SEEK_END);
+    if (std::ftell(f) == 0) {
+        if (std::fwrite(kMagic, 1, 8, f) != 8) {
+            std::cerr << "[MqttCapture] write header failed: " << path << "\n";
+            std::fclose(f);
+            return false;
+        }
+    }
+
+    s_file = f;
+    s_records = 0;
+    s_lastFlushNs = wallNs();
+    std::cout << "[MqttCapture] capturing to " << path << "\n";
+    return true;
+}
+
+void MqttCapture::close() noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    if (!s_file) return;
+
+    std::fclose(s_file);
+    s_file = nullptr;
+    std::cout << "[MqttCapture] closed, " << s_records << " messages captured\n";
+}
+
+bool MqttCapture::isOpen() noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    return s_file != nullptr;
+}
+
+void MqttCapture::record(std::string_view topic,
+                         std::string_view payload,
+                         std::uint64_t wallNs) noexcept
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    if (!s_file) return;
+
+    std::uint32_t topicLen   = static_cast<std::uint32_t>(topic.size());
+    std::uint32_t payloadLen = static_cast<std::uint32_t>(payload.size());
+
+    bool ok = std::fwrite(&wallNs,     sizeof(wallNs),     1, s_file) == 1 &&
+              std::fwrite(&topicLen,   sizeof(topicLen),   1, s_file) == 1 &&
+              std::fwrite(&payloadLen, sizeof(payloadLen), 1, s_file) == 1 &&
+              std::fwrite(topic.data(),   1, topicLen,   s_file) == topicLen &&
+              std::fwrite(payload.data(), 1, payloadLen, s_file) == payloadLen;
+
+    if (!ok) {
+        // Platte voll o.ä. -> Mitschnitt beenden, Betrieb läuft weiter
+        std::cerr << "[MqttCapture] write failed, capture stopped\n";
+        std::fclose(s_file);
+        s_file = nullptr;
+        return;
+    }
+    ++s_records;
+
+    if (wallNs - s_lastFlushNs >= 1000000000ULL) {
+        std::fflush(s_file);
+        s_lastFlushNs = wallNs;
+    }
+}
+
+bool MqttCapture::readAll(const std::string& path, std::vector<Record>& out) noexcept
+{
+    out.clear();
+
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "[MqttCapture] cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    char magic[8];
+    if (std::fread(magic, 1, 8, f) != 8 || std::memcmp(magic, kMagic, 8) != 0) {
+        std::cerr << "[MqttCapture] " << path << " is not a capture file\n";
+        std::fclose(f);
+        return false;
+    }
+
+    try {
+        for (;;) {
+            Record r;
+            std::uint32_t topicLen = 0, payloadLen = 0;
+            if (std::fread(&r.wallNs, sizeof(r.wallNs), 1, f) != 1) break;   // Ende
+            if (std::fread(&topicLen,   sizeof(topicLen),   1, f) != 1 ||
+                std::fread(&payloadLen, sizeof(payloadLen), 1, f) != 1) {
+                std::cerr << "[MqttCapture] truncated record, stopping at " << out.size() << "\n";
+                break;
+            }
+
+            r.topic.resize(topicLen);
+            r.payload.resize(payloadLen);
+            if ((topicLen   && std::fread(&r.topic[0],   1, topicLen,   f) != topicLen) ||
+                (payloadLen && std::fread(&r.payload[0], 1, payloadLen, f) != payloadLen)) {
+                std::cerr << "[MqttCapture] truncated record, stopping at " << out.size() << "\n";
+                break;
+            }
+            out.push_back(std::move(r));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[MqttCapture] read failed: " << e.what() << "\n";
+        std::fclose(f);
+        return false;
+    }
+
+    std::fclose(f);
+    return true;
+}
@@ -0,0 +1,51 @@
+// mqtt_capture.h
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Mitschnitt der rohen MQTT-Nachrichten (Topic, Payload, Empfangszeit),
+// abspielbar mit FMreplay für Durchsatz-/Latenzmessungen.
+//
+// Dateiformat: 8 Byte Magic "FMCAP001", danach je Nachricht
+//   u64 Empfangszeit (ns seit Epoch), u32 Topic-Länge, u32 Payload-Länge,
+//   Topic, Payload
+// Zahlen in Host-Byte-Order (Mitschnitt und Replay auf derselben Architektur).
+class MqttCapture {
+public:
+    struct Record {
+        std::uint64_t wallNs = 0;
+        std::string   topic;
+        std::string   payload;
+    };
+
+    // hängt an eine bestehende Datei an
+    static bool open(const std::string& path) noexcept;
+    static void close() noexcept;
+    static bool isOpen() noexcept;
+
+    // aus dem MQTT-Thread, gepuffert (fflush höchstens einmal pro Sekunde)
+    static void record(std::string_view topic,
+                       std::string_view payload,
+                       std::uint64_t wallNs) noexcept;
+
+    // komplette Datei lesen (für FMreplay)
+    static bool readAll(const std::string& path, std::vector<Record>& out) noexcept;
+
+    // ns seit Epoch (system_clock)
+    static std::uint64_t wallNs() noexcept;
+
+private:
+    MqttCapture() = delete;
+
+    static constexpr char kMagic[9] = "FMCAP001";
+
+    static inline std::mutex    s_mtx;
+    static inline std::FILE*    s_file = nullptr;
+    static inline std::uint64_t s_lastFlushNs = 0;
+    static inline std::uint64_t s_records = 0;
+};
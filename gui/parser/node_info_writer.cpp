@@ -14,22 +14,12 @@
 #include <unistd.h>  // ::sync()
 
 NodeInfoWriter::NodeInfoWriter(const std::string& outputPath)
-    : outputPath_(outputPath),
-      lastRun_(std::chrono::steady_clock::now() - std::chrono::seconds(10))
+    : outputPath_(outputPath)
 {
 }
 
 void NodeInfoWriter::tick()
 {
-    using namespace std::chrono;
-    auto now = steady_clock::now();
-
-    // nur alle 2 Sekunden wirklich arbeiten
-    if (now - lastRun_ < seconds(2)) {
-        return;
-    }
-    lastRun_ = now;
-
     updateIfNeeded();
 }
 
@@ -9,7 +9,7 @@ class NodeInfoWriter {
 public:
     explicit NodeInfoWriter(const std::string& outputPath = "/etc/svxlink/node_info.json");
 
-    // in der main-Loop regelmäßig aufrufen
+    // vom Scheduler alle 2 Sekunden aufgerufen
     void tick();
 
 private:
@@ -22,6 +22,5 @@ private:
     FMDatabase db_;
     std::string outputPath_;
 
-    std::chrono::steady_clock::time_point lastRun_;
     std::string lastJson_;  // zum Vergleich
 };
@@ -0,0 +1,180 @@
+// parser_settings.cpp
+#include "parser_settings.h"
+
+#include <fstream>
+#include <iostream>
+#include <cctype>
+
+namespace {
+
+std::string trim(const std::string& s)
+{
+    std::size_t start = 0;
+    while (start < s.size() &&
+           std::isspace(static_cast<unsigned char>(s[start]))) {
+        ++start;
+    }
+
+    std::size_t end = s.size();
+    while (end > start &&
+           std::isspace(static_cast<unsigned char>(s[end - 1]))) {
+        --end;
+    }
+
+    return s.substr(start, end - start);
+}
+
+bool toSize(const std::string& val, std::size_t& out)
+{
+    try {
+        long long v = std::stoll(val);
+        if (v < 0) return false;
+        out = static_cast<std::size_t>(v);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace
+
+bool ParserSettings::apply(const std::string& key, const std::string& val) noexcept
+{
+    if (key == "queue_capacity") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 16) return false;
+        queueCapacity = v;
+        return true;
+    }
+    if (key == "batch_size") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 1) return false;
+        batchSize = v;
+        return true;
+    }
+    if (key == "batch_flush_ms") {
+        std::size_t v = 0;
+        if (!toSize(val, v)) return false;
+        batchFlushMs = static_cast<unsigned>(v);
+        return true;
+    }
+    if (key == "retention_days") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 1) return false;
+        retentionDays = static_cast<unsigned>(v);
+        return true;
+    }
+    if (key == "retention_interval_min") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 1) return false;
+        retentionIntervalMin = static_cast<unsigned>(v);
+        return true;
+    }
+    if (key == "retention_chunk_rows") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 1) return false;
+        retentionChunkRows = v;
+        return true;
+    }
+    if (key == "retention_pause_ms") {
+        std::size_t v = 0;
+        if (!toSize(val, v)) return false;
+        retentionPauseMs = static_cast<unsigned>(v);
+        return true;
+    }
+    if (key == "stats_verify") {
+        if (val != "0" && val != "1") return false;
+        statsVerify = (val == "1");
+        return true;
+    }
+    if (key == "stats_threads") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 1 || v > 64) return false;
+        statsThreads = static_cast<unsigned>(v);
+        return true;
+    }
+    if (key == "spool_file") {
+        spoolFile = val;
+        return true;
+    }
+    if (key == "spool_max_mb") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 1) return false;
+        spoolMaxMb = v;
+        return true;
+    }
+    if (key == "mqtt_host") {
+        if (val.empty()) return false;
+        mqttHost = val;
+        return true;
+    }
+    if (key == "mqtt_port") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v < 1 || v > 65535) return false;
+        mqttPort = static_cast<int>(v);
+        return true;
+    }
+    if (key == "http_bind") {
+        if (val.empty()) return false;
+        httpBind = val;
+        return true;
+    }
+    if (key == "http_port") {
+        std::size_t v = 0;
+        if (!toSize(val, v) || v > 65535) return false;
+        httpPort = static_cast<int>(v);
+        return true;
+    }
+    if (key == "snapshot_dir") {
+        snapshotDir = val;
+        return true;
+    }
+    if (key == "country_prefix_file") {
+        countryPrefixFile = val;
+        return true;
+    }
+    if (key == "db_name") {
+        if (val.empty()) return false;
+        dbName = val;
+        return true;
+    }
+    if (key == "capture_file") {
+        captureFile = val;
+        return true;
+    }
+
+    return false;
+}
+
+bool ParserSettings::load(const std::string& path) noexcept
+{
+    std::ifstream in(path);
+    if (!in) {
+        // keine Datei -> Defaults
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        std::string t = trim(line);
+        if (t.empty()) continue;
+        if (t[0] == '#' || t[0] == ';' || t[0] == '[') continue;
+
+        auto posEq = t.find('=');
+        if (posEq == std::string::npos) continue;
+
+        std::string key = trim(t.substr(0, posEq));
+        std::string val = trim(t.substr(posEq + 1));
+
+        if (!apply(key, val)) {
+            std::cerr << "[ParserSettings] ignoriere ungültigen Eintrag: " << t << "\n";
+        }
+    }
+
+    std::cout << "[ParserSettings] " << path << " geladen\n";
+    return true;
+}
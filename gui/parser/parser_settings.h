@@ -0,0 +1,66 @@
+// parser_settings.h
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Optionale Laufzeit-Einstellungen für FMparser.
+// Datei: /etc/svxlink/fmparser.conf, Format key=value, Kommentare mit # oder ;
+// Fehlt die Datei oder ein Key, gelten die Defaults unten.
+class ParserSettings {
+public:
+    static bool load(const std::string& path = "/etc/svxlink/fmparser.conf") noexcept;
+
+    // Anzahl Slots in der Queue zwischen MQTT-Thread und DB-Writer
+    static inline std::size_t queueCapacity = 4096;
+
+    // Talk-Events sammeln und gemeinsam schreiben:
+    // Flush bei batchSize Events oder wenn das älteste Event batchFlushMs alt ist
+    static inline std::size_t batchSize    = 100;
+    static inline unsigned    batchFlushMs = 500;
+
+    // Retention für fmlastheard: alle retentionIntervalMin Minuten alles älter als
+    // retentionDays löschen, in Portionen von retentionChunkRows mit Pause dazwischen
+    static inline unsigned    retentionDays        = 365;
+    static inline unsigned    retentionIntervalMin = 60;
+    static inline std::size_t retentionChunkRows   = 5000;
+    static inline unsigned    retentionPauseMs     = 200;
+
+    // Statistik: laufende Aggregate bei jedem Lauf gegen einen Vollscan prüfen
+    static inline bool statsVerify = false;
+
+    // Vollscan (Rebuild beim Start, Verify) mit so vielen Threads/DB-Verbindungen
+    static inline unsigned statsThreads = 1;
+
+    // Spool-Datei für Events, die gerade nicht in die DB können (leer = aus)
+    static inline std::string spoolFile  = "/var/lib/fmparser/spool.bin";
+    static inline std::size_t spoolMaxMb = 64;
+
+    // MQTT-Broker (für Tests/Benchmarks auch ein lokaler mosquitto)
+    static inline std::string mqttHost = "mqtt.fm-funknetz.de";
+    static inline int         mqttPort = 1883;
+
+    // Datenbank (für Benchmarks eine eigene, z.B. fmbench)
+    static inline std::string dbName = "mmdvmdb";
+
+    // LiveApi (HTTP, JSON wie api.php) für Live-Status, Last-Heard und Top-Listen
+    // aus dem Speicher; api.php fragt dort zuerst. httpPort 0 = aus
+    static inline std::string httpBind = "127.0.0.1";
+    static inline int         httpPort = 8088;
+
+    // Statistik-Ergebnisse als statische JSON-Dateien (+ .gz) für den Webserver
+    // (leer = aus); das Verzeichnis muss existieren und für FMparser schreibbar sein
+    static inline std::string snapshotDir = "/var/www/html/stats";
+
+    // Präfix -> Ländercode (CountryPrefixes), leer oder fehlend = keine Ländercodes
+    // aus FMparser, api.php löst sie dann selbst auf
+    static inline std::string countryPrefixFile = "/etc/svxlink/country_prefixes.txt";
+
+    // rohe MQTT-Nachrichten mitschneiden (leer = aus), abspielbar mit FMreplay
+    static inline std::string captureFile;
+
+private:
+    ParserSettings() = delete;
+
+    static bool apply(const std::string& key, const std::string& val) noexcept;
+};
@@ -0,0 +1,255 @@
+// payload_parser.cpp
+#include "payload_parser.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+enum class ValueType { String, Number, Null, Bool };
+
+struct Token {
+    ValueType        type = ValueType::Null;
+    std::string_view text;   // String: ohne Anführungszeichen, sonst Rohtext
+};
+
+inline bool isWs(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline void skipWs(const char*& p, const char* e)
+{
+    while (p < e && isWs(*p)) ++p;
+}
+
+// UTF-8 prüfen wie nlohmann (ungültige Sequenzen -> Parse-Fehler)
+bool validUtf8(const unsigned char* p, const unsigned char* e)
+{
+    while (p < e) {
+        unsigned char c = *p;
+        if (c < 0x80) { ++p; continue; }
+
+        int n = 0;
+        if      (c >= 0xC2 && c <= 0xDF) n = 1;
+        else if (c >= 0xE0 && c <= 0xEF) n = 2;
+        else if (c >= 0xF0 && c <= 0xF4) n = 3;
+        else return false;
+
+        if (e - p <= n) return false;
+        for (int i = 1; i <= n; ++i) {
+            if ((p[i] & 0xC0) != 0x80) return false;
+        }
+        // überlange Kodierungen, Surrogates und > U+10FFFF
+        if (c == 0xE0 && p[1] < 0xA0) return false;
+        if (c == 0xED && p[1] > 0x9F) return false;
+        if (c == 0xF0 && p[1] < 0x90) return false;
+        if (c == 0xF4 && p[1] > 0x8F) return false;
+
+        p += n + 1;
+    }
+    return true;
+}
+
+// String ohne Escapes; Escapes -> false (Fallback), da sonst umkopiert werden müsste
+bool readString(const char*& p, const char* e, std::string_view& out)
+{
+    if (p >= e || *p != '"') return false;
+    const char* start = ++p;
+
+    while (p < e) {
+        char c = *p;
+        if (c == '"') {
+            out = std::string_view(start, static_cast<std::size_t>(p - start));
+            ++p;
+            return validUtf8(reinterpret_cast<const unsigned char*>(start),
+                             reinterpret_cast<const unsigned char*>(out.data() + out.size()));
+        }
+        if (c == '\\' || static_cast<unsigned char>(c) < 0x20) {
+            return false;
+        }
+        ++p;
+    }
+    return false;
+}
+
+bool readNumber(const char*& p, const char* e, std::string_view& out)
+{
+    const char* start = p;
+    if (p < e && *p == '-') ++p;
+
+    const char* digits = p;
+    while (p < e && *p >= '0' && *p <= '9') ++p;
+    if (p == digits) return false;
+    if (*digits == '0' && p - digits > 1) return false;   // führende Null
+
+    if (p < e && *p == '.') {
+        ++p;
+        const char* frac = p;
+        while (p < e && *p >= '0' && *p <= '9') ++p;
+        if (p == frac) return false;
+    }
+    if (p < e && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p < e && (*p == '+' || *p == '-')) ++p;
+        const char* ex = p;
+        while (p < e && *p >= '0' && *p <= '9') ++p;
+        if (p == ex) return false;
+    }
+
+    out = std::string_view(start, static_cast<std::size_t>(p - start));
+    return true;
+}
+
+bool readLiteral(const char*& p, const char* e, const char* lit)
+{
+    std::size_t n = std::strlen(lit);
+    if (static_cast<std::size_t>(e - p) < n || std::memcmp(p, lit, n) != 0) return false;
+    p += n;
+    return true;
+}
+
+bool readValue(const char*& p, const char* e, Token& tok)
+{
+    if (p >= e) return false;
+
+    switch (*p) {
+    case '"':
+        tok.type = ValueType::String;
+        return readString(p, e, tok.text);
+    case 'n':
+        tok.type = ValueType::Null;
+        return readLiteral(p, e, "null");
+    case 't':
+        tok.type = ValueType::Bool;
+        return readLiteral(p, e, "true");
+    case 'f':
+        tok.type = ValueType::Bool;
+        return readLiteral(p, e, "false");
+    case '{':
+    case '[':
+        // verschachtelte Werte kommen in den Payloads nicht vor -> nlohmann
+        return false;
+    default:
+        tok.type = ValueType::Number;
+        return readNumber(p, e, tok.text);
+    }
+}
+
+// Läuft über alle Einträge eines flachen JSON-Objekts und ruft
+// onMember(key, token) auf; onMember liefert false -> Fallback.
+template <typename Fn>
+bool forEachMember(std::string_view json, Fn&& onMember)
+{
+    const char* p = json.data();
+    const char* e = p + json.size();
+
+    skipWs(p, e);
+    if (p >= e || *p != '{') return false;
+    ++p;
+    skipWs(p, e);
+
+    if (p < e && *p == '}') {
+        ++p;
+    } else {
+        for (;;) {
+            std::string_view key;
+            if (!readString(p, e, key)) return false;
+
+            skipWs(p, e);
+            if (p >= e || *p != ':') return false;
+            ++p;
+            skipWs(p, e);
+
+            Token tok;
+            if (!readValue(p, e, tok)) return false;
+            if (!onMember(key, tok)) return false;
+
+            skipWs(p, e);
+            if (p < e && *p == ',') {
+                ++p;
+                skipWs(p, e);
+                continue;
+            }
+            if (p < e && *p == '}') {
+                ++p;
+                break;
+            }
+            return false;
+        }
+    }
+
+    // nach dem Objekt darf nur noch Whitespace kommen
+    skipWs(p, e);
+    return p == e;
+}
+
+// Zahl aus Token -> double, ohne Heap (strtod braucht einen nullterminierten Puffer)
+bool toDouble(std::string_view s, double& out)
+{
+    char buf[64];
+    if (s.empty() || s.size() >= sizeof(buf)) return false;
+    std::memcpy(buf, s.data(), s.size());
+    buf[s.size()] = '\0';
+
+    char* end = nullptr;
+    double v = std::strtod(buf, &end);
+    if (end == buf) return false;   // wie std::stod: kein Präfix lesbar
+    out = v;
+    return true;
+}
+
+// lat/lon: Zahl oder String mit Zahl, alles andere (null, bool) -> NaN
+// (Strings werden wie mit std::stod gelesen, das überspringt führenden Whitespace)
+void readCoordinate(const Token& tok, double& out)
+{
+    out = std::numeric_limits<double>::quiet_NaN();
+    if (tok.type == ValueType::Number || tok.type == ValueType::String) {
+        toDouble(tok.text, out);
+    }
+}
+
+} // namespace
+
+bool PayloadParser::parseTalk(std::string_view json, TalkFields& out) noexcept
+{
+    out = TalkFields{};
+
+    return forEachMember(json, [&out](std::string_view key, const Token& tok) {
+        std::string_view* field = nullptr;
+        if      (key == "time")   field = &out.time;
+        else if (key == "talk")   field = &out.talk;
+        else if (key == "call")   field = &out.call;
+        else if (key == "tg")     field = &out.tg;
+        else if (key == "server") field = &out.server;
+        else return true;   // andere Felder ignorieren
+
+        // nlohmann::json::value(key, "") wirft bei Nicht-Strings -> dort behandeln
+        if (tok.type != ValueType::String) return false;
+        *field = tok.text;
+        return true;
+    });
+}
+
+bool PayloadParser::parseNode(std::string_view json, NodeFields& out) noexcept
+{
+    out = NodeFields{};
+
+    return forEachMember(json, [&out](std::string_view key, const Token& tok) {
+        if (key == "lat") { readCoordinate(tok, out.lat); return true; }
+        if (key == "lon") { readCoordinate(tok, out.lon); return true; }
+
+        std::string_view* field = nullptr;
+        if      (key == "call")     field = &out.call;
+        else if (key == "location") field = &out.location;
+        else if (key == "locator")  field = &out.locator;
+        else if (key == "rx_freq")  field = &out.rxFreq;
+        else if (key == "tx_freq")  field = &out.txFreq;
+        else return true;
+
+        if (tok.type != ValueType::String) return false;
+        *field = tok.text;
+        return true;
+    });
+}
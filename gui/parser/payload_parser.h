@@ -0,0 +1,41 @@
+// payload_parser.h
+#pragma once
+
+#include <string_view>
+#include <limits>
+
+// Schneller Extraktor für die flachen JSON-Payloads vom FM-Funknetz.
+// Arbeitet direkt auf dem MQTT-Puffer, legt keinen JSON-Baum an und
+// alloziert nichts. Die string_views zeigen in den Payload.
+//
+// Liefert false, wenn der Payload nicht in das einfache Schema passt
+// (Escapes, unerwartete Typen, kaputtes JSON) - dann nimmt der Aufrufer
+// den Weg über nlohmann::json, der auch die Fehlermeldungen liefert.
+class PayloadParser {
+public:
+    // /server/statethr/...
+    struct TalkFields {
+        std::string_view time;
+        std::string_view talk;
+        std::string_view call;
+        std::string_view tg;
+        std::string_view server;
+    };
+
+    // /server/state/nodes/...
+    struct NodeFields {
+        std::string_view call;
+        std::string_view location;
+        std::string_view locator;
+        std::string_view rxFreq;
+        std::string_view txFreq;
+        double lat = std::numeric_limits<double>::quiet_NaN();
+        double lon = std::numeric_limits<double>::quiet_NaN();
+    };
+
+    static bool parseTalk(std::string_view json, TalkFields& out) noexcept;
+    static bool parseNode(std::string_view json, NodeFields& out) noexcept;
+
+private:
+    PayloadParser() = delete;
+};
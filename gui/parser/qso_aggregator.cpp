@@ -0,0 +1,305 @@
+// qso_aggregator.cpp
+#include "qso_aggregator.h"
+#include "callsign_dict.h"
+#include "fm_time.h"
+
+#include <algorithm>
+
+void QsoAggregator::onTalk(std::uint32_t callId, bool start, std::time_t t, int tg)
+{
+    if (callId == CallsignDict::kNone) return;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (start) {
+        // mehrfaches start -> letztes gewinnt
+        if (callId >= open_.size()) open_.resize(static_cast<std::size_t>(callId) + 1);
+        open_[callId] = OpenStart{t, tg};
+        return;
+    }
+
+    if (callId >= open_.size() || open_[callId].start == 0) {
+        return;   // stop ohne passendes start
+    }
+    OpenStart os = open_[callId];
+    open_[callId] = OpenStart{};
+
+    double dt = std::difftime(t, os.start);
+    // QSOs < 5s ignorieren
+    if (dt < 5.0) {
+        return;
+    }
+    addQso(callId, os.start, dt, os.tg);
+}
+
+QsoAggregator::DayBucket* QsoAggregator::bucketFor(std::int64_t day)
+{
+    // meistens der letzte Tag
+    for (auto it = days_.rbegin(); it != days_.rend(); ++it) {
+        if (it->day == day) return &*it;
+        if (it->day < day) {
+            DayBucket b;
+            b.day = day;
+            return &*days_.insert(it.base(), std::move(b));
+        }
+    }
+    DayBucket b;
+    b.day = day;
+    days_.push_front(std::move(b));
+    return &days_.front();
+}
+
+void QsoAggregator::addTo(WindowTotals& s, std::uint32_t callId, double seconds, int tg)
+{
+    if (callId >= s.perCall.size()) s.perCall.resize(static_cast<std::size_t>(callId) + 1);
+    auto& c = s.perCall[callId];
+    c.qsoCount     += 1;
+    c.totalSeconds += seconds;
+    s.perTg[tg]      += seconds;
+    s.perTgCount[tg] += 1;
+
+    auto& tc = s.perTgCall[tgCallKey(tg, callId)];
+    tc.qsoCount     += 1;
+    tc.totalSeconds += seconds;
+}
+
+// Dauern sind ganze Sekunden -> Abziehen ist exakt
+void QsoAggregator::subtract(WindowTotals& s, const DayBucket& b)
+{
+    for (const auto& kv : b.perCall) {
+        if (kv.first >= s.perCall.size()) continue;
+        CallAggregate& c = s.perCall[kv.first];
+        if (c.qsoCount <= kv.second.qsoCount) {
+            c = CallAggregate{};
+        } else {
+            c.qsoCount     -= kv.second.qsoCount;
+            c.totalSeconds -= kv.second.totalSeconds;
+        }
+    }
+    for (const auto& kv : b.perTgCount) {
+        auto it = s.perTgCount.find(kv.first);
+        if (it == s.perTgCount.end()) continue;
+        if (it->second <= kv.second) {
+            s.perTgCount.erase(it);
+            s.perTg.erase(kv.first);
+        } else {
+            it->second -= kv.second;
+            s.perTg[kv.first] -= b.perTg.at(kv.first);
+        }
+    }
+    for (const auto& kv : b.perTgCall) {
+        auto it = s.perTgCall.find(kv.first);
+        if (it == s.perTgCall.end()) continue;
+        if (it->second.qsoCount <= kv.second.qsoCount) {
+            s.perTgCall.erase(it);
+        } else {
+            it->second.qsoCount     -= kv.second.qsoCount;
+            it->second.totalSeconds -= kv.second.totalSeconds;
+        }
+    }
+}
+
+void QsoAggregator::add(WindowTotals& s, const WindowTotals& o)
+{
+    if (o.perCall.size() > s.perCall.size()) s.perCall.resize(o.perCall.size());
+    for (std::size_t i = 0; i < o.perCall.size(); ++i) {
+        s.perCall[i].qsoCount     += o.perCall[i].qsoCount;
+        s.perCall[i].totalSeconds += o.perCall[i].totalSeconds;
+    }
+    for (const auto& kv : o.perTg) {
+        s.perTg[kv.first] += kv.second;
+    }
+    for (const auto& kv : o.perTgCount) {
+        s.perTgCount[kv.first] += kv.second;
+    }
+    for (const auto& kv : o.perTgCall) {
+        auto& tc = s.perTgCall[kv.first];
+        tc.qsoCount     += kv.second.qsoCount;
+        tc.totalSeconds += kv.second.totalSeconds;
+    }
+}
+
+void QsoAggregator::addQso(std::uint32_t callId, std::time_t start, double seconds, int tg)
+{
+    int hour = 0;
+    std::int64_t day = FmTime::localDay(start, &hour);
+
+    // Start liegt vor dem längsten Fenster -> zählt nicht mehr
+    if (today_ != 0 && day <= today_ - kHistoryDays) {
+        return;
+    }
+    if (day > today_) {
+        slide(day);
+    }
+
+    DayBucket* b = bucketFor(day);
+
+    auto& c = b->perCall[callId];
+    c.qsoCount     += 1;
+    c.totalSeconds += seconds;
+    b->perTg[tg]      += seconds;
+    b->perTgCount[tg] += 1;
+    auto& tc = b->perTgCall[tgCallKey(tg, callId)];
+    tc.qsoCount     += 1;
+    tc.totalSeconds += seconds;
+    b->hours[static_cast<std::size_t>(hour)] += 1;
+
+    for (int w = Window7d; w < WindowCount; ++w) {
+        if (day > today_ - kWindowDays[w]) {
+            addTo(sums_[static_cast<std::size_t>(w)], callId, seconds, tg);
+        }
+    }
+
+    // 24h rechnet totals() aus den einzelnen QSOs
+    if (day >= today_ - 1) {
+        recent_.push_back(RecentQso{callId, start, seconds, tg});
+    }
+}
+
+void QsoAggregator::slide(std::int64_t today)
+{
+    if (today <= today_) return;
+    const std::int64_t prev = today_;
+    today_ = today;
+
+    // Tage, die seit prev aus einem Fenster gefallen sind, dort abziehen
+    for (int w = Window7d; w < WindowCount; ++w) {
+        const std::int64_t lo = prev - kWindowDays[w];    // schon abgezogen
+        const std::int64_t hi = today_ - kWindowDays[w];
+        for (const auto& b : days_) {
+            if (b.day > hi) break;
+            if (b.day > lo) subtract(sums_[static_cast<std::size_t>(w)], b);
+        }
+    }
+
+    while (!days_.empty() && days_.front().day <= today_ - kHistoryDays) {
+        days_.pop_front();
+    }
+
+    // starts ohne stop, die älter als das längste Fenster sind, zählen nie mehr
+    const std::int64_t firstDay = today_ - kHistoryDays + 1;
+    for (auto& os : open_) {
+        if (os.start != 0 && FmTime::localDay(os.start) < firstDay) {
+            os = OpenStart{};
+        }
+    }
+
+    // für 24h reicht gestern und heute
+    recent_.erase(std::remove_if(recent_.begin(), recent_.end(),
+                                 [this](const RecentQso& q) {
+                                     return FmTime::localDay(q.start) < today_ - 1;
+                                 }),
+                  recent_.end());
+}
+
+const char* QsoAggregator::windowName(Window w) noexcept
+{
+    switch (w) {
+    case Window24h:  return "24h";
+    case Window7d:   return "7d";
+    case Window30d:  return "30d";
+    case Window365d: return "365d";
+    case WindowCount: break;
+    }
+    return "";
+}
+
+void QsoAggregator::totals(std::time_t now, Totals& out)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    slide(FmTime::localDay(now));
+
+    for (int w = Window7d; w < WindowCount; ++w) {
+        out.windows[static_cast<std::size_t>(w)] = sums_[static_cast<std::size_t>(w)];
+    }
+
+    WindowTotals& day = out.windows[Window24h];
+    day.perCall.clear();
+    day.perTg.clear();
+    day.perTgCount.clear();
+    day.perTgCall.clear();
+    for (const auto& q : recent_) {
+        if (q.start > now - 86400 && q.start <= now) {
+            addTo(day, q.callId, q.seconds, q.tg);
+        }
+    }
+
+    for (auto& d : out.heatmapWeek) {
+        d.fill(0);
+    }
+    for (const auto& b : days_) {
+        if (b.day <= today_ - kHeatmapDays) continue;
+        int weekdayIndex = FmTime::weekday(b.day);   // 0=Montag..6=Sonntag
+        for (std::size_t h = 0; h < 24; ++h) {
+            out.heatmapWeek[static_cast<std::size_t>(weekdayIndex)][h] += b.hours[h];
+        }
+    }
+}
+
+void QsoAggregator::mergeFrom(QsoAggregator& other)
+{
+    if (&other == this) return;
+    std::scoped_lock lock(mtx_, other.mtx_);
+
+    // beide auf denselben Tag ziehen, dann passen Buckets und Fenster-Summen
+    const std::int64_t today = std::max(today_, other.today_);
+    if (today == 0) return;   // beide leer
+    slide(today);
+    other.slide(today);
+
+    for (auto& ob : other.days_) {
+        DayBucket* b = bucketFor(ob.day);
+        if (b->perCall.empty() && b->perTgCall.empty()) {
+            std::swap(*b, ob);   // Tag nur im anderen Shard
+            continue;
+        }
+        for (const auto& kv : ob.perCall) {
+            auto& c = b->perCall[kv.first];
+            c.qsoCount     += kv.second.qsoCount;
+            c.totalSeconds += kv.second.totalSeconds;
+        }
+        for (const auto& kv : ob.perTg) {
+            b->perTg[kv.first] += kv.second;
+        }
+        for (const auto& kv : ob.perTgCount) {
+            b->perTgCount[kv.first] += kv.second;
+        }
+        for (const auto& kv : ob.perTgCall) {
+            auto& tc = b->perTgCall[kv.first];
+            tc.qsoCount     += kv.second.qsoCount;
+            tc.totalSeconds += kv.second.totalSeconds;
+        }
+        for (std::size_t h = 0; h < 24; ++h) {
+            b->hours[h] += ob.hours[h];
+        }
+    }
+
+    for (int w = Window7d; w < WindowCount; ++w) {
+        add(sums_[static_cast<std::size_t>(w)], other.sums_[static_cast<std::size_t>(w)]);
+    }
+
+    recent_.insert(recent_.end(), other.recent_.begin(), other.recent_.end());
+
+    if (other.open_.size() > open_.size()) open_.resize(other.open_.size());
+    for (std::size_t i = 0; i < other.open_.size(); ++i) {
+        if (other.open_[i].start > open_[i].start) open_[i] = other.open_[i];
+    }
+
+    other.open_.clear();
+    other.days_.clear();
+    other.recent_.clear();
+    other.sums_ = {};
+    other.today_ = 0;
+}
+
+void QsoAggregator::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    open_.clear();
+    days_.clear();
+    recent_.clear();
+    sums_ = {};
+    today_ = 0;
+}
@@ -0,0 +1,129 @@
+// qso_aggregator.h
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using FMQsoHeatmap = std::array<std::array<std::uint32_t, 24>, 7>; // [weekday][hour], weekday: 0=Mo..6=So
+
+// QSO-Statistik, laufend beim Schreiben der Talk-Events mitgeführt.
+// Ein QSO = start .. stop desselben Callsigns, mindestens 5 s, gezählt am Tag
+// (lokale Zeit) seines Starts. Pro Tag ein Bucket je Callsign/TG plus Stunden
+// für die Heatmap, aufbewahrt für das längste Fenster (365 Tage).
+// Fenster 7d/30d/365d: heute und die 6/29/364 Tage davor, je mit laufender
+// Summe; rutscht ein Tag aus einem Fenster, wird sein Bucket dort abgezogen.
+// Fenster 24h: Tages-Buckets sind zu grob, dafür werden die QSOs seit gestern
+// einzeln gehalten und bei totals() aufsummiert.
+// Heatmap: heute und die 6 Tage davor.
+//
+// Gefüttert vom DB-Writer (nur was in fmlastheard steht), gelesen von
+// statistics() im main-Thread -> intern gelockt.
+// FMDatabase::scanQsoAggregates() baut dasselbe aus fmlastheard neu auf (Rebuild/Verify).
+// Callsigns als ID aus dem CallsignDict: Summen und offene starts liegen in
+// Vektoren mit der ID als Index, Namen braucht erst die Top-Liste.
+class QsoAggregator {
+public:
+    enum Window { Window24h = 0, Window7d, Window30d, Window365d, WindowCount };
+
+    static constexpr int kWindowDays[WindowCount] = {1, 7, 30, 365};
+    static constexpr int kHistoryDays = 365;   // Buckets, Rebuild-Scan
+    static constexpr int kHeatmapDays = 7;
+
+    // Wert der Spalte fmstats.window
+    static const char* windowName(Window w) noexcept;
+
+    struct CallAggregate {
+        std::uint64_t qsoCount     = 0;
+        double        totalSeconds = 0.0;
+    };
+
+    using CallAggVec = std::vector<CallAggregate>;                     // Index: Callsign-ID
+    using CallAggMap = std::unordered_map<std::uint32_t, CallAggregate>;   // je Tag (dünn besetzt)
+    using TgAggMap   = std::unordered_map<int, double>;
+    using TgCountMap = std::unordered_map<int, std::uint64_t>;
+    using TgCallMap  = std::unordered_map<std::uint64_t, CallAggregate>;   // Schlüssel: tgCallKey()
+
+    struct WindowTotals {
+        CallAggVec perCall;   // qsoCount == 0 -> nicht im Fenster
+        TgAggMap   perTg;
+        TgCountMap perTgCount;
+        TgCallMap  perTgCall;   // je TG und Callsign (Top-Listen pro TG)
+    };
+
+    static std::uint64_t tgCallKey(int tg, std::uint32_t callId) noexcept
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(tg)) << 32) | callId;
+    }
+    static int keyTg(std::uint64_t key) noexcept
+    {
+        return static_cast<int>(static_cast<std::uint32_t>(key >> 32));
+    }
+    static std::uint32_t keyCall(std::uint64_t key) noexcept
+    {
+        return static_cast<std::uint32_t>(key);
+    }
+
+    struct Totals {
+        std::array<WindowTotals, WindowCount> windows;
+        FMQsoHeatmap                          heatmapWeek{};
+    };
+
+    // Talk-Events je Callsign (ID aus CallsignDict) in zeitlicher Reihenfolge
+    void onTalk(std::uint32_t callId, bool start, std::time_t t, int tg);
+
+    // Fenster bis now nachziehen und Summen kopieren
+    void totals(std::time_t now, Totals& out);
+
+    // other dazuaddieren, danach ist other leer. Nur für Teil-Aggregate über
+    // disjunkte Callsigns (Shards von scanQsoAggregates), sonst zählen die
+    // offenen starts doppelt.
+    void mergeFrom(QsoAggregator& other);
+
+    void clear();
+
+private:
+    struct OpenStart {
+        std::time_t start = 0;   // 0 -> kein offenes start
+        int         tg    = 0;
+    };
+
+    struct DayBucket {
+        std::int64_t                 day = 0;
+        CallAggMap                   perCall;
+        TgAggMap                     perTg;
+        TgCountMap                   perTgCount;
+        TgCallMap                    perTgCall;
+        std::array<std::uint32_t, 24> hours{};
+    };
+
+    struct RecentQso {
+        std::uint32_t callId  = 0;
+        std::time_t   start   = 0;
+        double        seconds = 0.0;
+        int           tg      = 0;
+    };
+
+    void addQso(std::uint32_t callId, std::time_t start, double seconds, int tg);
+    void slide(std::int64_t today);
+    DayBucket* bucketFor(std::int64_t day);
+
+    static void addTo(WindowTotals& s, std::uint32_t callId, double seconds, int tg);
+    static void subtract(WindowTotals& s, const DayBucket& b);
+    static void add(WindowTotals& s, const WindowTotals& o);
+
+    mutable std::mutex mtx_;
+
+    std::vector<OpenStart> open_;     // Index: Callsign-ID
+    std::deque<DayBucket>  days_;     // aufsteigend nach day
+    std::deque<RecentQso>  recent_;   // Start seit gestern 00:00 (für 24h)
+
+    // laufende Summen je Tages-Fenster ([Window24h] unbenutzt)
+    std::array<WindowTotals, WindowCount> sums_;
+
+    std::int64_t today_ = 0;
+};
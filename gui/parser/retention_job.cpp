@@ -0,0 +1,73 @@
+// retention_job.cpp
+#include "retention_job.h"
+
+#include <iostream>
+
+RetentionJob::RetentionJob(unsigned days,
+                           unsigned intervalMinutes,
+                           std::size_t chunkRows,
+                           unsigned pauseMs)
+    : days_(days),
+      interval_(intervalMinutes),
+      chunkRows_(chunkRows > 0 ? chunkRows : 1),
+      pause_(pauseMs),
+      // erster Lauf kurz nach dem Start
+      lastRun_(std::chrono::steady_clock::now() - std::chrono::minutes(intervalMinutes)
+               + std::chrono::minutes(1))
+{
+}
+
+std::chrono::milliseconds RetentionJob::tick()
+{
+    using namespace std::chrono;
+    auto now = steady_clock::now();
+
+    if (!running_) {
+        if (now - lastRun_ < interval_) {
+            return duration_cast<milliseconds>(interval_ - (now - lastRun_)) + milliseconds(1);
+        }
+        running_    = true;
+        lastRun_    = now;
+        runDeleted_ = 0;
+        runChunks_  = 0;
+        runDbTime_  = nanoseconds(0);
+    } else if (now - lastChunk_ < pause_) {
+        // Pause zwischen den Portionen, damit der Writer nicht auf Locks wartet
+        return duration_cast<milliseconds>(pause_ - (now - lastChunk_)) + milliseconds(1);
+    }
+
+    std::uint64_t deleted = 0;
+    bool ok = db_.deleteExpiredChunk(days_, chunkRows_, deleted);
+
+    lastChunk_  = steady_clock::now();
+    runDbTime_ += lastChunk_ - now;
+    runDeleted_ += deleted;
+    ++runChunks_;
+
+    // fertig, wenn eine Portion nicht mehr voll wurde (oder bei Fehler)
+    if (!ok || deleted < chunkRows_) {
+        finishRun(ok);
+        return duration_cast<milliseconds>(interval_);
+    }
+    return pause_;
+}
+
+void RetentionJob::finishRun(bool ok)
+{
+    using namespace std::chrono;
+    running_ = false;
+
+    auto wall = duration_cast<milliseconds>(steady_clock::now() - lastRun_).count();
+    auto db   = duration_cast<milliseconds>(runDbTime_).count();
+
+    if (!ok) {
+        std::cerr << "[RetentionJob] run aborted after " << runDeleted_ << " rows\n";
+        return;
+    }
+
+    if (runDeleted_ > 0) {
+        std::cout << "[RetentionJob] removed " << runDeleted_ << " rows older than "
+                  << days_ << " days in " << runChunks_ << " chunks, "
+                  << db << " ms DB / " << wall << " ms total\n";
+    }
+}
@@ -0,0 +1,40 @@
+// retention_job.h
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include "fmdatabase.h"
+
+// Löscht alte fmlastheard-Zeilen in kleinen Portionen statt bei jedem Event.
+// tick() läuft im Scheduler und blockiert höchstens für einen
+// DELETE ... LIMIT n; zwischen den Portionen liegt eine Pause.
+class RetentionJob {
+public:
+    RetentionJob(unsigned days,
+                 unsigned intervalMinutes,
+                 std::size_t chunkRows,
+                 unsigned pauseMs);
+
+    // liefert die Wartezeit bis zum nächsten Aufruf
+    // (Pause während eines Laufs, sonst bis zum nächsten Lauf)
+    std::chrono::milliseconds tick();
+
+private:
+    void finishRun(bool ok);
+
+    FMDatabase db_;
+
+    unsigned                  days_;
+    std::chrono::minutes      interval_;
+    std::size_t               chunkRows_;
+    std::chrono::milliseconds pause_;
+
+    std::chrono::steady_clock::time_point lastRun_;     // Start des letzten Laufs
+    std::chrono::steady_clock::time_point lastChunk_;   // Ende der letzten Portion
+
+    // aktueller Lauf
+    bool                     running_     = false;
+    std::uint64_t            runDeleted_  = 0;
+    std::uint64_t            runChunks_   = 0;
+    std::chrono::nanoseconds runDbTime_{0};
+};
@@ -0,0 +1,118 @@
+// scheduler.cpp
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+Scheduler::Scheduler()
+{
+    efd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (efd_ < 0) {
+        // ohne eventfd wird stop() erst nach dem aktuellen Timeout bemerkt
+        std::cerr << "[Scheduler] eventfd failed: " << std::strerror(errno) << "\n";
+    }
+}
+
+Scheduler::~Scheduler()
+{
+    if (efd_ >= 0) {
+        ::close(efd_);
+        efd_ = -1;
+    }
+}
+
+void Scheduler::every(const std::string& name,
+                      Duration interval,
+                      std::function<void()> fn,
+                      Duration firstDelay)
+{
+    Task t;
+    t.name     = name;
+    t.interval = interval > Duration(0) ? interval : Duration(1);
+    t.fn       = [fn = std::move(fn)]() { fn(); return Duration(0); };
+    t.due      = Clock::now() + firstDelay;
+    tasks_.push_back(std::move(t));
+}
+
+void Scheduler::dynamic(const std::string& name,
+                        Duration firstDelay,
+                        std::function<Duration()> fn)
+{
+    Task t;
+    t.name = name;
+    t.fn   = std::move(fn);
+    t.due  = Clock::now() + firstDelay;
+    tasks_.push_back(std::move(t));
+}
+
+void Scheduler::stop() noexcept
+{
+    stop_.store(true);
+
+    if (efd_ >= 0) {
+        std::uint64_t one = 1;
+        ssize_t n = ::write(efd_, &one, sizeof(one));   // async-signal-safe
+        (void)n;
+    }
+}
+
+void Scheduler::runTask(Task& t)
+{
+    Duration next(0);
+    try {
+        next = t.fn();
+    } catch (const std::exception& e) {
+        std::cerr << "[Scheduler] task " << t.name << " failed: " << e.what() << "\n";
+    } catch (...) {
+        std::cerr << "[Scheduler] task " << t.name << " failed\n";
+    }
+
+    auto now = Clock::now();
+    if (t.interval > Duration(0)) {
+        // im Takt bleiben, verpasste Termine nicht nachholen
+        t.due += t.interval;
+        if (t.due <= now) t.due = now + t.interval;
+    } else {
+        t.due = now + std::max(next, Duration(1));
+    }
+}
+
+void Scheduler::run()
+{
+    while (!stop_.load()) {
+        if (tasks_.empty()) {
+            pollfd pfd{efd_, POLLIN, 0};
+            ::poll(&pfd, efd_ >= 0 ? 1 : 0, -1);
+            continue;
+        }
+
+        // nächste fällige Aufgabe
+        auto due = tasks_.front().due;
+        for (const auto& t : tasks_) {
+            if (t.due < due) due = t.due;
+        }
+
+        auto now = Clock::now();
+        if (due > now) {
+            // aufrunden, sonst wacht poll() kurz vor dem Termin auf
+            auto wait = std::chrono::duration_cast<Duration>(due - now) + Duration(1);
+            pollfd pfd{efd_, POLLIN, 0};
+            int rc = ::poll(&pfd, efd_ >= 0 ? 1 : 0, static_cast<int>(wait.count()));
+            if (rc < 0 && errno != EINTR) {
+                std::cerr << "[Scheduler] poll failed: " << std::strerror(errno) << "\n";
+            }
+            continue;   // stop_ prüfen, Termine neu bestimmen
+        }
+
+        for (auto& t : tasks_) {
+            if (stop_.load()) break;
+            if (t.due <= now) runTask(t);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// scheduler.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Führt periodische Aufgaben im aufrufenden Thread aus (main).
+// Schläft bis zur nächsten fälligen Aufgabe in poll() auf einem eventfd,
+// dazwischen gibt es keine Wakeups. stop() ist async-signal-safe und
+// beendet run() sofort, auch mitten im Warten.
+class Scheduler {
+public:
+    using Clock    = std::chrono::steady_clock;
+    using Duration = std::chrono::milliseconds;
+
+    Scheduler();
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // feste Periode; firstDelay = Wartezeit bis zum ersten Aufruf
+    void every(const std::string& name,
+               Duration interval,
+               std::function<void()> fn,
+               Duration firstDelay = Duration(0));
+
+    // fn liefert selbst die Wartezeit bis zum nächsten Aufruf
+    void dynamic(const std::string& name,
+                 Duration firstDelay,
+                 std::function<Duration()> fn);
+
+    // blockiert bis stop(); Aufgaben nur vorher registrieren
+    void run();
+
+    // auch aus einem Signal-Handler
+    void stop() noexcept;
+
+private:
+    struct Task {
+        std::string                name;
+        std::function<Duration()>  fn;
+        Duration                   interval{0};   // 0 -> fn bestimmt den Abstand
+        Clock::time_point          due;
+    };
+
+    void runTask(Task& t);
+
+    std::vector<Task> tasks_;   // wenige Einträge, lineare Suche genügt
+
+    int               efd_ = -1;
+    std::atomic<bool> stop_{false};
+};
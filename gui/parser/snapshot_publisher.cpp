@@ -0,0 +1,291 @@
+// snapshot_publisher.cpp
+#include "snapshot_publisher.h"
+
+#include "fmdatabase.h"
+#include "stats_json.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+using nlohmann::ordered_json;
+
+SnapshotPublisher::SnapshotPublisher(std::string dir)
+    : dir_(std::move(dir))
+{
+}
+
+bool SnapshotPublisher::publish(const FMStatsSnapshot& snap) noexcept
+{
+    struct stat st{};
+    if (::stat(dir_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        if (!dirMissing_) {
+            std::cerr << "[SnapshotPublisher] " << dir_ << " not available, no snapshot files\n";
+            dirMissing_ = true;
+        }
+        return false;
+    }
+    dirMissing_ = false;
+
+    // Stand vom letzten Lauf (auch über Neustarts): unveränderte Dateien behalten
+    if (!loaded_) {
+        loadManifest();
+        loaded_ = true;
+    }
+
+    try {
+        const std::time_t now = snap.createdAt ? snap.createdAt : std::time(nullptr);
+        FileMap next;
+        bool    changed = false;
+        bool    ok      = true;
+
+        ok &= publishFile("fmheatmap.json", StatsJson::heatmap(snap.heatmapWeek), now, next, changed);
+
+        for (const auto& w : snap.windows) {
+            const std::string win = w.window;
+
+            ok &= publishFile("fm_topTalkgroups-" + win + ".json",
+                              StatsJson::topTalkgroups(w), now, next, changed);
+            ok &= publishFile("fm_hallOfFameWeek-" + win + ".json",
+                              StatsJson::hallOfFame(w), now, next, changed);
+
+            ok &= publishFile("fm_callsignTop10Count-" + win + "-all.json",
+                              StatsJson::callsByCount(w.topCallsByCount), now, next, changed);
+            ok &= publishFile("fm_callsignTop10Duration-" + win + "-all.json",
+                              StatsJson::callsByDuration(w.topCallsByDuration), now, next, changed);
+
+            ok &= publishFile("fm_callsignTop10Count-" + win + "-monitored.json",
+                              StatsJson::callsByCount(w.monitored.topCallsByCount), now, next, changed);
+            ok &= publishFile("fm_callsignTop10Duration-" + win + "-monitored.json",
+                              StatsJson::callsByDuration(w.monitored.topCallsByDuration), now, next, changed);
+
+            for (const auto& l : w.perTg) {
+                const std::string tg = std::to_string(l.tg);
+                ok &= publishFile("fm_callsignTop10Count-" + win + "-tg" + tg + ".json",
+                                  StatsJson::callsByCount(l.topCallsByCount), now, next, changed);
+                ok &= publishFile("fm_callsignTop10Duration-" + win + "-tg" + tg + ".json",
+                                  StatsJson::callsByDuration(l.topCallsByDuration), now, next, changed);
+            }
+        }
+
+        // was es im neuen Stand nicht mehr gibt, verschwindet (api.php liefert dann [])
+        for (const auto& [name, info] : files_) {
+            if (next.count(name)) continue;
+            ::unlink((dir_ + "/" + name).c_str());
+            ::unlink((dir_ + "/" + name + ".gz").c_str());
+            changed = true;
+        }
+
+        files_.swap(next);
+
+        if (changed || !exists("manifest.json")) {
+            ++version_;
+            ok &= writeManifest(now);
+        }
+        return ok;
+    } catch (const std::exception& e) {
+        std::cerr << "[SnapshotPublisher] publish failed: " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool SnapshotPublisher::publishFile(const std::string& name, const std::string& json,
+                                    std::time_t now, FileMap& next, bool& changed) noexcept
+{
+    try {
+        const std::string etag = etagOf(json);
+
+        auto old = files_.find(name);
+        if (old != files_.end() && old->second.etag == etag &&
+            exists(name) && exists(name + ".gz")) {
+            next[name] = old->second;
+            return true;
+        }
+
+        // .gz zuerst: wer die neue .json sieht, bekommt auch die neue .gz
+        std::string gz;
+        bool written = gzip(json, gz);
+        if (!written) {
+            std::cerr << "[SnapshotPublisher] gzip failed for " << name << "\n";
+        }
+        written = written && writeAtomic(name + ".gz", gz, now) && writeAtomic(name, json, now);
+        if (!written) {
+            // alte Datei bleibt stehen (nicht als verwaist löschen)
+            if (old != files_.end()) next[name] = old->second;
+            return false;
+        }
+
+        FileInfo& info = next[name];
+        info.etag      = etag;
+        info.mtime     = now;
+        info.bytes     = json.size();
+        info.gzipBytes = gz.size();
+        changed = true;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[SnapshotPublisher] " << name << ": " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool SnapshotPublisher::writeManifest(std::time_t createdAt) noexcept
+{
+    try {
+        ordered_json files = ordered_json::object();
+
+        // sortiert, damit gleiche Stände gleiche Manifeste ergeben
+        std::vector<std::string> names;
+        names.reserve(files_.size());
+        for (const auto& kv : files_) names.push_back(kv.first);
+        std::sort(names.begin(), names.end());
+
+        for (const auto& name : names) {
+            const FileInfo& f = files_.at(name);
+            files[name] = {
+                {"etag",       f.etag},
+                {"mtime",      static_cast<std::int64_t>(f.mtime)},
+                {"bytes",      f.bytes},
+                {"gzip_bytes", f.gzipBytes},
+            };
+        }
+
+        ordered_json m = {
+            {"version", version_},
+            {"created", static_cast<std::int64_t>(createdAt)},
+            {"files",   std::move(files)},
+        };
+
+        const std::string json = m.dump(-1, ' ', false, ordered_json::error_handler_t::replace);
+        std::string gz;
+        if (!gzip(json, gz)) return false;
+        return writeAtomic("manifest.json.gz", gz, createdAt) &&
+               writeAtomic("manifest.json", json, createdAt);
+    } catch (const std::exception& e) {
+        std::cerr << "[SnapshotPublisher] manifest: " << e.what() << "\n";
+        return false;
+    }
+}
+
+void SnapshotPublisher::loadManifest() noexcept
+{
+    try {
+        std::ifstream in(dir_ + "/manifest.json");
+        if (!in) return;
+
+        ordered_json m = ordered_json::parse(in, nullptr, false);
+        if (m.is_discarded() || !m.is_object()) return;
+
+        version_ = m.value("version", std::uint64_t{0});
+        const auto files = m.find("files");
+        if (files == m.end() || !files->is_object()) return;
+
+        for (const auto& [name, f] : files->items()) {
+            if (!f.is_object()) continue;
+            FileInfo info;
+            info.etag      = f.value("etag", std::string());
+            info.mtime     = static_cast<std::time_t>(f.value("mtime", std::int64_t{0}));
+            info.bytes     = f.value("bytes", std::size_t{0});
+            info.gzipBytes = f.value("gzip_bytes", std::size_t{0});
+            files_[name]   = std::move(info);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[SnapshotPublisher] manifest unreadable, rewriting all: " << e.what() << "\n";
+        files_.clear();
+    }
+}
+
+// .name.tmp schreiben, mtime setzen, per rename() an die Stelle von name
+bool SnapshotPublisher::writeAtomic(const std::string& name, const std::string& data,
+                                    std::time_t mtime) noexcept
+{
+    const std::string path = dir_ + "/" + name;
+    const std::string tmp  = dir_ + "/." + name + ".tmp";
+
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[SnapshotPublisher] open " << tmp << " failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    std::size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[SnapshotPublisher] write " << tmp << " failed: " << std::strerror(errno) << "\n";
+            ::close(fd);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        off += static_cast<std::size_t>(n);
+    }
+
+    // Last-Modified/ETag von Apache hängen an der mtime: Zeitpunkt des Stands
+    struct timespec times[2];
+    times[0].tv_sec  = mtime;
+    times[0].tv_nsec = 0;
+    times[1]         = times[0];
+    ::futimens(fd, times);
+
+    if (::close(fd) != 0 || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "[SnapshotPublisher] replace " << path << " failed: " << std::strerror(errno) << "\n";
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotPublisher::exists(const std::string& name) const noexcept
+{
+    struct stat st{};
+    return ::stat((dir_ + "/" + name).c_str(), &st) == 0;
+}
+
+// gzip-Format (nicht zlib), damit Apache es mit Content-Encoding: gzip ausliefern kann
+bool SnapshotPublisher::gzip(const std::string& in, std::string& out) noexcept
+{
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    try {
+        out.resize(deflateBound(&zs, static_cast<uLong>(in.size())) + 32);
+    } catch (...) {
+        deflateEnd(&zs);
+        return false;
+    }
+
+    zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in  = static_cast<uInt>(in.size());
+    zs.next_out  = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END;
+}
+
+// starkes ETag aus dem Inhalt (FNV-1a 64), für Clients, die das Manifest lesen
+std::string SnapshotPublisher::etagOf(const std::string& data)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "\"%016llx\"", static_cast<unsigned long long>(h));
+    return buf;
+}
@@ -0,0 +1,60 @@
+// snapshot_publisher.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+
+struct FMStatsSnapshot;
+
+// Legt nach jedem Statistik-Lauf die Antworten der Statistik-Abfragen als
+// statische Dateien unter den Webroot, damit Apache sie ohne PHP und MySQL
+// ausliefert (ETag/Last-Modified aus mtime und Größe, 304 bei If-None-Match):
+//   fmheatmap.json
+//   fm_topTalkgroups-<window>.json, fm_hallOfFameWeek-<window>.json
+//   fm_callsignTop10Count-<window>-all|monitored|tg<N>.json (ebenso ...Duration)
+//   manifest.json: version, Zeitpunkt und je Datei etag, mtime, Größen
+// Zu jeder Datei eine vorkomprimierte .json.gz (gzip -9).
+//
+// Jede Datei wird als .<name>.tmp geschrieben und per rename() ersetzt, Leser
+// sehen nie eine halbe Datei. Unveränderte Inhalte werden nicht neu geschrieben,
+// mtime und damit ETag/Last-Modified bleiben stabil. Dateien, die es nicht mehr
+// gibt (TG nicht mehr in den Listen), werden gelöscht. manifest.json kommt
+// zuletzt und nur, wenn sich etwas geändert hat.
+// Nur vom StatsWorker-Thread benutzt.
+class SnapshotPublisher {
+public:
+    explicit SnapshotPublisher(std::string dir);
+
+    // false -> Verzeichnis fehlt oder eine Datei ließ sich nicht schreiben (geloggt)
+    bool publish(const FMStatsSnapshot& snap) noexcept;
+
+    std::uint64_t version() const noexcept { return version_; }
+
+private:
+    struct FileInfo {
+        std::string etag;
+        std::time_t mtime     = 0;
+        std::size_t bytes     = 0;
+        std::size_t gzipBytes = 0;
+    };
+    using FileMap = std::unordered_map<std::string, FileInfo>;
+
+    void loadManifest() noexcept;
+    bool publishFile(const std::string& name, const std::string& json,
+                     std::time_t now, FileMap& next, bool& changed) noexcept;
+    bool writeManifest(std::time_t createdAt) noexcept;
+    bool writeAtomic(const std::string& name, const std::string& data, std::time_t mtime) noexcept;
+    bool exists(const std::string& name) const noexcept;
+
+    static bool        gzip(const std::string& in, std::string& out) noexcept;
+    static std::string etagOf(const std::string& data);
+
+    std::string   dir_;
+    bool          loaded_     = false;
+    bool          dirMissing_ = false;   // nur einmal melden
+    std::uint64_t version_    = 0;
+    FileMap       files_;                // zuletzt veröffentlicht
+};
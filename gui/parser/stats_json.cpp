@@ -0,0 +1,115 @@
+// stats_json.cpp
+#include "stats_json.h"
+#include "callsign_dict.h"
+
+#include <algorithm>
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+using nlohmann::ordered_json;
+
+namespace {
+
+// json_encode(..., JSON_UNESCAPED_UNICODE); kaputtes UTF-8 ersetzen statt werfen
+std::string dump(const ordered_json& j)
+{
+    return j.dump(-1, ' ', false, ordered_json::error_handler_t::replace);
+}
+
+// wie prefix_to_country() in api.php, aber einmal je Callsign aufgelöst
+ordered_json countryOf(const std::string& call)
+{
+    std::string cc = CallsignDict::countryOf(call);
+    if (cc.empty()) return nullptr;
+    return cc;
+}
+
+double average(double total, std::uint64_t count)
+{
+    return count > 0 ? total / static_cast<double>(count) : 0.0;
+}
+
+} // namespace
+
+std::string StatsJson::callsByCount(const std::vector<FMCallQsoCount>& rows)
+{
+    ordered_json out = ordered_json::array();
+    for (std::size_t i = 0; i < rows.size() && i < kRows; ++i) {
+        out.push_back({{"callsign", rows[i].callsign}, {"cnt", rows[i].qsoCount},
+                       {"country_code", countryOf(rows[i].callsign)}});
+    }
+    return dump(out);
+}
+
+std::string StatsJson::callsByDuration(const std::vector<FMCallDuration>& rows)
+{
+    ordered_json out = ordered_json::array();
+    for (std::size_t i = 0; i < rows.size() && i < kRows; ++i) {
+        out.push_back({{"callsign", rows[i].callsign}, {"sec", rows[i].totalSeconds},
+                       {"country_code", countryOf(rows[i].callsign)}});
+    }
+    return dump(out);
+}
+
+std::string StatsJson::hallOfFame(const FMStatsWindow& w)
+{
+    ordered_json out = ordered_json::array();
+    for (std::size_t i = 0; i < w.topCallsByScore.size() && i < kRows; ++i) {
+        const auto& c = w.topCallsByScore[i];
+        out.push_back({
+            {"callsign",  c.callsign},
+            {"qso_count", c.qsoCount},
+            {"total_sec", c.totalSeconds},
+            {"score",     c.score},
+            {"avg_sec",   average(c.totalSeconds, c.qsoCount)},
+            {"country_code", countryOf(c.callsign)},
+        });
+    }
+    return dump(out);
+}
+
+std::string StatsJson::topTalkgroups(const FMStatsWindow& w)
+{
+    ordered_json out = ordered_json::array();
+    for (std::size_t i = 0; i < w.topTgByDuration.size() && i < kRows; ++i) {
+        const auto& t = w.topTgByDuration[i];
+        out.push_back({
+            {"tg",        t.tg},
+            {"cnt",       t.qsoCount},
+            {"total_sec", t.totalSeconds},
+            {"avg_sec",   average(t.totalSeconds, t.qsoCount)},
+        });
+    }
+    return dump(out);
+}
+
+std::string StatsJson::heatmap(const FMQsoHeatmap& h)
+{
+    ordered_json out = ordered_json::array();
+    for (int wd = 0; wd < 7; ++wd) {
+        for (int hour = 0; hour < 24; ++hour) {
+            out.push_back({{"weekday", wd}, {"hour", hour}, {"count", h[wd][hour]}});
+        }
+    }
+    return dump(out);
+}
+
+const FMStatsWindow* StatsJson::findWindow(const std::vector<FMStatsWindow>& windows,
+                                           const std::string& name)
+{
+    const char* want = (name == "24h" || name == "7d" || name == "30d" || name == "365d")
+                           ? name.c_str() : "30d";
+    for (const auto& w : windows) {
+        if (std::strcmp(w.window, want) == 0) return &w;
+    }
+    return nullptr;
+}
+
+const FMTgCallLists* StatsJson::findTg(const FMStatsWindow& w, int tg)
+{
+    // perTg ist aufsteigend nach tg
+    auto it = std::lower_bound(w.perTg.begin(), w.perTg.end(), tg,
+                               [](const FMTgCallLists& l, int t) { return l.tg < t; });
+    if (it == w.perTg.end() || it->tg != tg) return nullptr;
+    return &*it;
+}
@@ -0,0 +1,41 @@
+// stats_json.h
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "fmdatabase.h"
+
+// JSON der Statistik-Abfragen von api.php aus einem FMStatsSnapshot, gleiche
+// Felder und Reihenfolge wie dort (country_code aus CallsignDict). Gemeinsam für
+// LiveApi (HTTP) und SnapshotPublisher (statische Dateien).
+class StatsJson {
+public:
+    static constexpr std::size_t kRows = 10;   // LIMIT 10 in api.php
+
+    // [{callsign, cnt, country_code}] bzw. [{callsign, sec, country_code}]
+    static std::string callsByCount(const std::vector<FMCallQsoCount>& rows);
+    static std::string callsByDuration(const std::vector<FMCallDuration>& rows);
+
+    // fm_hallOfFameWeek: [{callsign, qso_count, total_sec, score, avg_sec, country_code}]
+    static std::string hallOfFame(const FMStatsWindow& w);
+
+    // fm_topTalkgroups: [{tg, cnt, total_sec, avg_sec}]
+    static std::string topTalkgroups(const FMStatsWindow& w);
+
+    // fmheatmap: [{weekday, hour, count}] für alle 7 x 24 Felder
+    static std::string heatmap(const FMQsoHeatmap& h);
+
+    // "[]" für fehlende Listen
+    static std::string emptyList() { return "[]"; }
+
+    // wie fm_stats_window() in api.php: 24h|7d|30d|365d, sonst 30d
+    static const FMStatsWindow* findWindow(const std::vector<FMStatsWindow>& windows,
+                                           const std::string& name);
+
+    // Listen einer TG (scope 'tg'), nullptr wenn es für sie keine gibt
+    static const FMTgCallLists* findTg(const FMStatsWindow& w, int tg);
+
+private:
+    StatsJson() = delete;
+};
@@ -0,0 +1,120 @@
+// stats_worker.cpp
+#include "stats_worker.h"
+#include "parser_settings.h"
+
+#include <chrono>
+#include <iostream>
+
+StatsWorker::StatsWorker(QsoAggregator* live)
+    : live_(live),
+      publisher_(ParserSettings::snapshotDir),
+      publish_(!ParserSettings::snapshotDir.empty())
+{
+    db_.setCancelFlag(&cancel_);
+}
+
+StatsWorker::~StatsWorker()
+{
+    stop();
+}
+
+void StatsWorker::start()
+{
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    cancel_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        busy_ = false;
+    }
+    thread_ = std::thread(&StatsWorker::run, this);
+}
+
+bool StatsWorker::trigger() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!running_.load()) return false;
+        if (busy_) {
+            std::uint64_t s = ++skipped_;
+            std::cerr << "[StatsWorker] previous run still busy, skipped (total: " << s << ")\n";
+            return false;
+        }
+        busy_ = true;
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void StatsWorker::stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+        cancel_ = true;
+    }
+
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::cout << "[StatsWorker] stopped: runs=" << runs_.load()
+              << " failures=" << failures_.load()
+              << " skipped=" << skipped_.load() << "\n";
+}
+
+std::shared_ptr<const FMStatsSnapshot> StatsWorker::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(snapMtx_);
+    return snapshot_;
+}
+
+void StatsWorker::run()
+{
+    // db_ wurde im main-Thread verbunden, benutzt wird es nur noch hier
+    mysql_thread_init();
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return busy_ || !running_.load(); });
+            if (!running_.load()) break;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        auto snap = std::make_shared<FMStatsSnapshot>();
+        bool ok = db_.statistics(live_, snap.get());
+        const std::int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    std::chrono::steady_clock::now() - t0).count();
+
+        if (cancel_.load()) {
+            std::cout << "[StatsWorker] run cancelled after " << ms << " ms\n";
+            break;
+        }
+
+        if (ok) {
+            // Dateien für den Webserver; Fehler sind geloggt, fmstats ist trotzdem neu
+            if (publish_) publisher_.publish(*snap);
+
+            std::lock_guard<std::mutex> lock(snapMtx_);
+            snapshot_ = std::move(snap);
+        }
+
+        lastRunMs_ = ms;
+        lastRunAt_ = std::time(nullptr);
+        lastRunOk_ = ok;
+        ++runs_;
+        if (!ok) ++failures_;
+        std::cout << "[StatsWorker] run " << (ok ? "done" : "failed") << " in " << ms << " ms\n";
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        busy_ = false;
+    }
+
+    mysql_thread_end();
+}
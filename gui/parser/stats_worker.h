@@ -0,0 +1,80 @@
+// stats_worker.h
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "fmdatabase.h"
+#include "snapshot_publisher.h"
+
+class QsoAggregator;
+
+// Statistik (FMDatabase::statistics) in einem eigenen Thread mit eigener
+// DB-Verbindung, damit Scan und fmstats-Schreiben den Scheduler in main
+// (node_info, Retention, SIGTERM) nicht aufhalten.
+// trigger() stößt einen Lauf an; läuft noch einer, wird der Auftrag
+// verworfen -> nie zwei Läufe gleichzeitig, auch kein Stau.
+// stop() bricht einen laufenden Lauf an der nächsten Prüfstelle ab
+// (zwischen den Schritten, pro Scan-Zeile, pro INSERT), fmstats bleibt dann
+// auf dem alten Stand.
+// Nach jedem erfolgreichen Lauf schreibt der SnapshotPublisher die Ergebnisse
+// zusätzlich als statische JSON-Dateien (snapshot_dir, leer = aus).
+class StatsWorker {
+public:
+    // live = laufend mitgeführte Aggregate (DB-Writer), nullptr -> Vollscan
+    explicit StatsWorker(QsoAggregator* live);
+    ~StatsWorker();
+
+    StatsWorker(const StatsWorker&) = delete;
+    StatsWorker& operator=(const StatsWorker&) = delete;
+
+    void start();
+
+    // vom Scheduler; false -> voriger Lauf noch nicht fertig, nichts angestoßen
+    bool trigger() noexcept;
+
+    // laufenden Lauf abbrechen und Thread beenden
+    void stop() noexcept;
+
+    // Monitoring: letzter beendeter Lauf (Dauer, Ende als Unix-Zeit, 0 = noch keiner)
+    std::int64_t  lastRunMs() const noexcept { return lastRunMs_.load(); }
+    std::time_t   lastRunAt() const noexcept { return lastRunAt_.load(); }
+    bool          lastRunOk() const noexcept { return lastRunOk_.load(); }
+    std::uint64_t runs()      const noexcept { return runs_.load(); }
+    std::uint64_t failures()  const noexcept { return failures_.load(); }
+    std::uint64_t skipped()   const noexcept { return skipped_.load(); }
+
+    // Stand des letzten erfolgreichen Laufs (wie in fmstats), nullptr vor dem ersten
+    std::shared_ptr<const FMStatsSnapshot> snapshot() const;
+
+private:
+    void run();
+
+    FMDatabase        db_;
+    QsoAggregator*    live_;
+    SnapshotPublisher publisher_;
+    bool              publish_;
+
+    std::thread             thread_;
+    std::mutex              mtx_;
+    std::condition_variable cv_;
+    bool                    busy_ = false;   // unter mtx_: angestoßen oder aktiv
+
+    mutable std::mutex                     snapMtx_;
+    std::shared_ptr<const FMStatsSnapshot> snapshot_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> cancel_{false};
+
+    std::atomic<std::int64_t>  lastRunMs_{0};
+    std::atomic<std::time_t>   lastRunAt_{0};
+    std::atomic<bool>          lastRunOk_{false};
+    std::atomic<std::uint64_t> runs_{0};
+    std::atomic<std::uint64_t> failures_{0};
+    std::atomic<std::uint64_t> skipped_{0};
+};
@@ -0,0 +1,51 @@
+// top_k.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Die k besten Werte nach better(a, b) ("a ist besser als b"), ohne alle
+// Kandidaten zu sortieren: Heap mit höchstens k Einträgen, oben liegt der
+// schlechteste -> ein Vergleich pro Kandidat, log k nur beim Ersetzen.
+// better muss eine strenge Ordnung sein (Gleichstand selbst auflösen,
+// sonst hängt die Reihenfolge von der Eingabe ab).
+template <typename T, typename Better>
+class TopK {
+public:
+    TopK(std::size_t k, Better better)
+        : k_(k), better_(better)
+    {
+        heap_.reserve(k_);
+    }
+
+    void offer(const T& v)
+    {
+        if (k_ == 0) return;
+
+        if (heap_.size() < k_) {
+            heap_.push_back(v);
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+            return;
+        }
+        if (better_(v, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), better_);
+            heap_.back() = v;
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+        }
+    }
+
+    // bester zuerst; danach ist der Heap leer
+    std::vector<T> take()
+    {
+        std::sort_heap(heap_.begin(), heap_.end(), better_);
+        std::vector<T> out;
+        out.swap(heap_);
+        return out;
+    }
+
+private:
+    std::size_t    k_;
+    Better         better_;
+    std::vector<T> heap_;
+};
@@ -21,7 +21,7 @@ git build-essential cmake libusb-1.0-0-dev \
 libasound2-dev libfftw3-dev libgps-dev \
 libwxgtk3.2-dev logrotate curl ca-certificates \
 libmariadb-dev libmariadb-dev-compat mariadb-server \
-apache2 php libapache2-mod-php php-mysql wget php-curl libmosquitto-dev nlohmann-json3-dev
+apache2 php libapache2-mod-php php-mysql wget php-curl libmosquitto-dev nlohmann-json3-dev zlib1g-dev
 apt-get autoremove -y || true
 apt-get clean || true
 
@@ -42,12 +42,58 @@ echo "MariaDB initialized."
 # copy GUI
 cp -R gui/html/* /var/www/html
 
+# SSE-Stream von FMparser (LiveApi) unter /fmevents durchreichen; Port wie
+# http_port in fmparser.conf (api.php liest ihn dort selbst)
+FM_HTTP_PORT="$(sed -n 's/^[[:space:]]*http_port[[:space:]]*=[[:space:]]*\([0-9]\+\).*/\1/p' \
+  /etc/svxlink/fmparser.conf 2>/dev/null | tail -n 1 || true)"
+FM_HTTP_PORT="${FM_HTTP_PORT:-8088}"
+a2enmod proxy proxy_http
+cat >/etc/apache2/conf-available/fmparser-events.conf <<EOCONF
+# Server-Sent Events: aktive Stationen live aus FMparser (siehe http_port in fmparser.conf)
+ProxyPass        /fmevents http://127.0.0.1:${FM_HTTP_PORT}/events flushpackets=on timeout=3600
+ProxyPassReverse /fmevents http://127.0.0.1:${FM_HTTP_PORT}/events
+<Location /fmevents>
+  SetEnv no-gzip 1
+</Location>
+EOCONF
+a2enconf fmparser-events
+
+# Statistik-Dateien von FMparser (snapshot_dir): statisch mit ETag/304,
+# vorkomprimierte .json.gz für Clients mit Accept-Encoding: gzip
+install -d -o svxlink -g svxlink -m 755 /var/www/html/stats
+a2enmod rewrite headers
+cat >/etc/apache2/conf-available/fmparser-stats.conf <<'EOCONF'
+<Directory /var/www/html/stats>
+  RewriteEngine On
+  RewriteCond %{HTTP:Accept-Encoding} gzip
+  RewriteCond %{REQUEST_FILENAME}.gz -f
+  RewriteRule ^(.+\.json)$ $1.gz [L]
+
+  <FilesMatch "\.json\.gz$">
+    ForceType application/json
+    Header set Content-Encoding gzip
+    SetEnv no-gzip 1
+  </FilesMatch>
+  <FilesMatch "\.json(\.gz)?$">
+    Header append Vary Accept-Encoding
+    # immer beim Server nachfragen, unverändert -> 304
+    Header set Cache-Control "no-cache"
+  </FilesMatch>
+</Directory>
+EOCONF
+a2enconf fmparser-stats
+systemctl reload apache2 || true
+
 #make parser
 cd gui/parser
 make -j 4
+# Präfix -> Ländercode für FMparser (country_prefix_file in fmparser.conf)
+install -m 644 country_prefixes.txt /etc/svxlink/country_prefixes.txt
 # set file permissions
 chown svxlink:svxlink /etc/svxlink/node_info.json
 chown svxlink:svxlink /etc/svxlink/svxlink.conf
+# spool for events while the database is unavailable
+install -d -o svxlink -g svxlink -m 750 /var/lib/fmparser
 
 # allow user svxlink to restart the service AND reboot the system
 SYSTEMCTL_BIN="$(command -v systemctl || echo /usr/bin/systemctl)"